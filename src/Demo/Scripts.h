@@ -10,15 +10,13 @@
 namespace Demo {
 
 struct SpinnyScript : public Engine::Core::Script {
-  Engine::Graphics::Transform *transform;
   float rotationSpeed = 1.0f;
 
   SpinnyScript(Engine::Core::Entity entity, float rotationSpeed = 1.0f)
-      : Engine::Core::Script(entity), rotationSpeed(rotationSpeed), transform(nullptr) {}
-  void OnCreate() override { transform = entity.GetComponent<Engine::Graphics::Transform>(); }
+      : Engine::Core::Script(entity), rotationSpeed(rotationSpeed) {}
 
   void OnUpdate(Engine::Core::Clock const &clock) override {
-    Engine::Maths::Vector3 oldRotation = transform->rotation.EulerAngles();
+    auto transform = entity.ModifyComponent<Engine::Graphics::Transform>();
     transform->rotation = (Engine::Maths::Transformations::RotateAroundAxis(Engine::Maths::Vector3(0, 1, 0),
                                                                             rotationSpeed * clock.deltaTime * 0.2f) *
                            transform->rotation)
@@ -38,16 +36,16 @@ struct SpinnyScriptDSO : public Engine::ScriptDSO {
 };
 
 struct BobbyScript : public Engine::Core::Script {
-  Engine::Graphics::Transform *transform;
   float initialY;
   float bobbingAmplitude;
 
   BobbyScript(Engine::Core::Entity entity, float bobbingAmplitude)
-      : Engine::Core::Script(entity), bobbingAmplitude(bobbingAmplitude), transform(nullptr) {}
+      : Engine::Core::Script(entity), bobbingAmplitude(bobbingAmplitude) {}
 
-  void OnStart() override { initialY = transform->position.y(); }
-  void OnCreate() override { transform = entity.GetComponent<Engine::Graphics::Transform>(); }
+  // Transforms are not cached, as they can be relocated within their pool
+  void OnStart() override { initialY = entity.GetComponent<Engine::Graphics::Transform>()->position.y(); }
   void OnUpdate(Engine::Core::Clock const &clock) override {
+    auto transform = entity.ModifyComponent<Engine::Graphics::Transform>();
     transform->position.y() = initialY + std::sin(clock.time) * bobbingAmplitude;
   }
 
@@ -4,6 +4,7 @@
 #include "Util/FileIO.h"
 #include "Util/Macros.h"
 #include <array>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -155,29 +156,40 @@ class AssetManager {
     inline static typeID value = -1;
   };
   inline static typeID nextFreeType = 0;
+  inline static std::mutex typeIDMutex; // Asset managers of different threads share the type IDs
 
   std::array<ListableManager *, std::numeric_limits<typeID>::max()> typeManagers;
+  // Loads may be requested by several scenes at once. Loaders load dependencies through the same manager, hence the
+  // lock has to be recursive.
+  mutable std::recursive_mutex managerMutex;
+
+  template <typename T_Asset> static inline typeID TypeIDOf() {
+    std::lock_guard lock(typeIDMutex);
+    if (AssetTypeID<T_Asset>::value == typeID(-1)) {
+      AssetTypeID<T_Asset>::value = nextFreeType++;
+    }
+    return AssetTypeID<T_Asset>::value;
+  }
 
 public:
   AssetManager() : typeManagers(nullptr) {}
   ~AssetManager() {
-    for (int c = 0; c < nextFreeType; c++) {
-      if (typeManagers[c])
-        delete typeManagers[c];
+    for (auto typeManager : typeManagers) {
+      if (typeManager)
+        delete typeManager;
     }
   }
 
   template <typename T_Asset> inline bool IsRegistered() const {
+    std::lock_guard lock(managerMutex);
     return AssetTypeID<T_Asset>::value != typeID(-1) && typeManagers[AssetTypeID<T_Asset>::value];
   }
 
   template <typename T_Asset, TypeManager<T_Asset> T_Manager>
   inline T_Manager *RegisterAssetType(T_Manager const &manager) {
-    if (AssetTypeID<T_Asset>::value == typeID(-1)) {
-      AssetTypeID<T_Asset>::value = nextFreeType++;
-    }
-    auto listableManager = typeManagers[AssetTypeID<T_Asset>::value] =
-        new ListableTypeManagerImpl<T_Asset, T_Manager>(manager);
+    typeID type = TypeIDOf<T_Asset>();
+    std::lock_guard lock(managerMutex);
+    auto listableManager = typeManagers[type] = new ListableTypeManagerImpl<T_Asset, T_Manager>(manager);
     return &dynamic_cast<ListableTypeManagerImpl<T_Asset, T_Manager> *>(listableManager)->manager;
   }
 
@@ -191,7 +203,9 @@ public:
     return RegisterAssetType<T_Asset, T_Manager>(T_Manager(args...));
   }
 
+  // Safe to call from several threads, loads are serialised
   template <typename T_Asset> inline T_Asset LoadAsset(char const *assetName) {
+    std::lock_guard lock(managerMutex);
     if (AssetTypeID<T_Asset>::value == typeID(-1)) {
       ENGINE_ERROR("Tried to load unregistered asset type {}!", typeid(T_Asset).name());
       return T_Asset();
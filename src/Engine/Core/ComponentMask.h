@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifndef COMPONENT_MASK_WORDS
+#define COMPONENT_MASK_WORDS 2 // At most 3, see componentID
+#endif
+
+namespace Engine::Core {
+
+// Fixed-size bit set holding the component signature of an entity. All operations work on every word without
+// branching, so testing a filter costs the same no matter which bits it contains.
+class ComponentMask {
+  std::array<uint64_t, COMPONENT_MASK_WORDS> words;
+
+public:
+  static constexpr size_t BIT_COUNT = 64 * COMPONENT_MASK_WORDS;
+
+  constexpr ComponentMask() : words{} {}
+
+  static constexpr ComponentMask Bit(size_t bit) {
+    ComponentMask mask{};
+    mask.words[bit >> 6] = uint64_t(1) << (bit & 63);
+    return mask;
+  }
+
+  inline bool Test(size_t bit) const { return (words[bit >> 6] >> (bit & 63)) & 1; }
+  inline void Set(size_t bit) { words[bit >> 6] |= uint64_t(1) << (bit & 63); }
+  inline void Clear(size_t bit) { words[bit >> 6] &= ~(uint64_t(1) << (bit & 63)); }
+
+  // True if every bit of other is set in this mask
+  inline bool Contains(ComponentMask const &other) const {
+    uint64_t missing = 0;
+    for (size_t i = 0; i < COMPONENT_MASK_WORDS; i++) {
+      missing |= other.words[i] & ~words[i];
+    }
+    return missing == 0;
+  }
+
+  // Calls fn(bit) for every set bit in increasing order
+  template <typename Fn> inline void ForEachBit(Fn const &fn) const {
+    for (size_t i = 0; i < COMPONENT_MASK_WORDS; i++) {
+      for (uint64_t word = words[i]; word; word &= word - 1) {
+        fn(64 * i + std::countr_zero(word));
+      }
+    }
+  }
+
+  inline bool Any() const {
+    uint64_t any = 0;
+    for (size_t i = 0; i < COMPONENT_MASK_WORDS; i++) {
+      any |= words[i];
+    }
+    return any != 0;
+  }
+
+  constexpr ComponentMask operator|(ComponentMask const &other) const {
+    ComponentMask result{};
+    for (size_t i = 0; i < COMPONENT_MASK_WORDS; i++) {
+      result.words[i] = words[i] | other.words[i];
+    }
+    return result;
+  }
+  constexpr ComponentMask operator&(ComponentMask const &other) const {
+    ComponentMask result{};
+    for (size_t i = 0; i < COMPONENT_MASK_WORDS; i++) {
+      result.words[i] = words[i] & other.words[i];
+    }
+    return result;
+  }
+  constexpr ComponentMask operator~() const {
+    ComponentMask result{};
+    for (size_t i = 0; i < COMPONENT_MASK_WORDS; i++) {
+      result.words[i] = ~words[i];
+    }
+    return result;
+  }
+  inline ComponentMask &operator|=(ComponentMask const &other) { return *this = *this | other; }
+  inline ComponentMask &operator&=(ComponentMask const &other) { return *this = *this & other; }
+  constexpr bool operator==(ComponentMask const &other) const { return words == other.words; }
+
+  struct Hash {
+    inline size_t operator()(ComponentMask const &mask) const {
+      uint64_t hash = 0;
+      for (size_t i = 0; i < COMPONENT_MASK_WORDS; i++) {
+        hash = (hash ^ mask.words[i]) * 0x100000001b3ull;
+      }
+      return size_t(hash ^ (hash >> 32));
+    }
+  };
+};
+
+} // namespace Engine::Core
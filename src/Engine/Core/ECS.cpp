@@ -1,49 +1,118 @@
 #include "ECS.h"
 
+#include "Core/ECSCommandBuffer.h"
 #include "Core/HierarchyComponent.h"
 #include "Debug/Logging.h"
 
-#define GIVE_LIFE(entity) aliveAndComponentFlags[entity] = ALIVE_FLAG | ACTIVE_FLAG;
+#define GIVE_LIFE(entity)                                                                                              \
+  aliveAndComponentFlags[IndexOf(entity)] = ALIVE_FLAG | ACTIVE_FLAG | ACTIVE_IN_HIERARCHY_FLAG;                       \
+  aliveEntities.Set(IndexOf(entity));                                                                                  \
+  activeEntities.Set(IndexOf(entity));                                                                                 \
+  activeInHierarchyEntities.Set(IndexOf(entity));
 
-#define KILL(entity) aliveAndComponentFlags[entity] = 0;
+#define KILL(entity)                                                                                                   \
+  aliveAndComponentFlags[IndexOf(entity)] = ComponentMask();                                                           \
+  aliveEntities.Clear(IndexOf(entity));                                                                                \
+  activeEntities.Clear(IndexOf(entity));                                                                               \
+  activeInHierarchyEntities.Clear(IndexOf(entity));
+
+#define COMPONENT_BITS(flags) ((flags) & ~(ALIVE_FLAG | ACTIVE_FLAG | ACTIVE_IN_HIERARCHY_FLAG))
+
+#define NEXT_GENERATION(entity) ((entity) + (uint32_t(1) << ENTITY_INDEX_BITS))
+
+#define NOT_MATCHED uint32_t(-1)
+
+#define SNAPSHOT_MAGIC 0x31534345 // "ECS1"
+
+#define ENTITY_IN_NO_ECS 0
+#define ENTITY_IN_SNAPSHOT 1
+
+static std::atomic<uint64_t> nextECSSerial = 0;
 
 namespace Engine::Core {
-Component *ECS::AddComponent(EntityId e, ComponentIndex componentIndex) {
-  if (!(aliveAndComponentFlags[e] & ALIVE_FLAG)) {
-    ENGINE_ERROR("Tried to attach component to dead entity!") return nullptr;
+bool ECS::CanAddComponent(EntityId e, ComponentIndex componentIndex) const {
+  if (!IsAlive(e)) {
+    ENGINE_ERROR("Tried to attach component to dead entity!") return false;
   }
   if (HasComponent(e, componentIndex)) {
-    ENGINE_ERROR("Tried to attach same component twice!") return nullptr;
+    ENGINE_ERROR("Tried to attach same component twice!") return false;
   }
-  aliveAndComponentFlags[e] |= uint64_t(1) << componentIndex;
-  return componentArrays[componentIndex]->AddComponent(e);
+  return true;
 }
 
-Component *ECS::GetComponent(EntityId e, ComponentIndex componentIndex) const {
-  if (!(aliveAndComponentFlags[e] & ALIVE_FLAG)) {
-    ENGINE_ERROR("Tried to query component off dead entity!") return nullptr;
+bool ECS::CanAccessComponent(EntityId e, ComponentIndex componentIndex) const {
+  if (!IsAlive(e)) {
+    ENGINE_ERROR("Tried to query component off dead entity!") return false;
   }
   if (!HasComponent(e, componentIndex)) {
-    ENGINE_ERROR("Tried to query component the entity does not have!") return nullptr;
+    ENGINE_ERROR("Tried to query component the entity does not have!") return false;
+  }
+  return true;
+}
+
+Component *ECS::AddComponent(EntityId e, ComponentIndex componentIndex) {
+  if (!CanAddComponent(e, componentIndex)) {
+    return nullptr;
+  }
+  aliveAndComponentFlags[IndexOf(e)].Set(componentIndex);
+  Component *component = componentArrays[componentIndex]->AddComponent(e);
+  UpdateQueries(e);
+  return component;
+}
+
+Component *ECS::GetComponent(EntityId e, ComponentIndex componentIndex) const {
+  if (!CanAccessComponent(e, componentIndex)) {
+    return nullptr;
   }
   return componentArrays[componentIndex]->GetComponent(e);
 }
 
-bool ECS::HasComponent(EntityId e, ComponentIndex componentIndex) const {
-  return aliveAndComponentFlags[e] & (uint64_t(1) << componentIndex);
+void ECS::CachedQuery::Update(EntityId e, ComponentMask const &flags) {
+  uint32_t index = IndexOf(e);
+  bool matching = flags.Contains(filterMask);
+  bool listed = index < positions.size() && positions[index] != NOT_MATCHED;
+  if (matching && !listed) {
+    if (positions.size() <= index) {
+      positions.resize(index + 1, NOT_MATCHED);
+    }
+    positions[index] = static_cast<uint32_t>(matches.size());
+    matches.push_back(e);
+  } else if (!matching && listed) {
+    EntityId last = matches.back();
+    matches[positions[index]] = last;
+    positions[IndexOf(last)] = positions[index];
+    positions[index] = NOT_MATCHED;
+    matches.pop_back();
+  }
 }
 
-void ECS::RemoveComponent(EntityId e, ComponentIndex componentIndex) {
-  if (!(aliveAndComponentFlags[e] & ALIVE_FLAG)) {
-    ENGINE_ERROR("Tried to query component off dead entity!");
+ECS::CachedQuery &ECS::GetCachedQuery(ComponentMask filterMask) {
+  // References to elements of an unordered_map survive insertions, so only the lookup and creation are guarded
+  std::lock_guard lock(queryMutex);
+  auto query = queries.find(filterMask);
+  if (query != queries.end()) {
+    return query->second;
   }
-  if (!HasComponent(e, componentIndex)) {
-    ENGINE_ERROR("Tried to query component the entity does not have!");
+  CachedQuery &newQuery = queries.emplace(filterMask, CachedQuery(filterMask)).first->second;
+  ForEachMatchingIndex(filterMask,
+                       [&](size_t index) { newQuery.Update(handles[index], aliveAndComponentFlags[index]); });
+  return newQuery;
+}
+
+void ECS::UpdateQueries(EntityId e) {
+  for (auto &[_, query] : queries) {
+    query.Update(e, aliveAndComponentFlags[IndexOf(e)]);
   }
-  componentArrays[componentIndex]->RemoveComponent(e);
 }
 
-ECS::ECS() : aliveAndComponentFlags(MAX_ENTITY_NUMBER), firstFreeEntity(0), unusedEntityIDs(), componentArrays() {
+ECS::ECS()
+    : aliveAndComponentFlags(INITIAL_ENTITY_CAPACITY), handles(INITIAL_ENTITY_CAPACITY), aliveEntities(),
+      activeEntities(), activeInHierarchyEntities(), queries(), queryMutex(), firstFreeEntity(0),
+      unusedEntityIDs(), componentArrays(), version(1), serial(nextECSSerial++), commandBuffers(),
+      commandBufferMutex(), resources() {
+  for (uint32_t index = 0; index < handles.size(); index++) {
+    handles[index] = index;
+  }
   componentArrays.fill(nullptr);
 }
 ECS::~ECS() {
@@ -53,61 +122,471 @@ ECS::~ECS() {
   }
 }
 
+componentID ECS::NextComponentID() {
+  ENGINE_ASSERT(nextComponentID < MAX_COMPONENT_NUMBER, "Tried to register more than {} component types!",
+                MAX_COMPONENT_NUMBER)
+  return nextComponentID++;
+}
+
 EntityId ECS::_CreateEntity() {
   EntityId newEntity;
   if (!unusedEntityIDs.empty()) {
-    newEntity = unusedEntityIDs.top();
+    newEntity = handles[unusedEntityIDs.top()];
     unusedEntityIDs.pop();
   } else if (firstFreeEntity < MAX_ENTITY_NUMBER) {
-    newEntity = firstFreeEntity++;
+    ReserveEntities(firstFreeEntity + 1);
+    newEntity = handles[firstFreeEntity++];
   } else {
-    ENGINE_ERROR("Tried to create a new entity when max number was reached!")
+    ENGINE_ERROR("Tried to create a new entity when max number was reached!") return EntityId(-1);
   }
 
   GIVE_LIFE(newEntity)
+  UpdateQueries(newEntity);
+  for (Observer *observer : observers) {
+    observer->OnCreate(newEntity);
+  }
 
   return newEntity;
 }
 
+std::vector<EntityId> ECS::CreateEntities(uint32_t count) {
+  std::vector<EntityId> newEntities;
+  newEntities.reserve(count);
+  while (newEntities.size() < count && !unusedEntityIDs.empty()) {
+    newEntities.push_back(handles[unusedEntityIDs.top()]);
+    unusedEntityIDs.pop();
+  }
+
+  uint32_t missing = count - uint32_t(newEntities.size());
+  if (missing > MAX_ENTITY_NUMBER - firstFreeEntity) {
+    ENGINE_ERROR("Tried to create {} entities when only {} more fit!", count,
+                 newEntities.size() + MAX_ENTITY_NUMBER - firstFreeEntity)
+    missing = MAX_ENTITY_NUMBER - firstFreeEntity;
+  }
+  ReserveEntities(firstFreeEntity + missing);
+  for (uint32_t i = 0; i < missing; i++) {
+    newEntities.push_back(handles[firstFreeEntity++]);
+  }
+
+  // Every query requires at least one component, so none of them can match the new entities yet
+  for (EntityId e : newEntities) {
+    GIVE_LIFE(e)
+    for (Observer *observer : observers) {
+      observer->OnCreate(e);
+    }
+  }
+  return newEntities;
+}
+
+void ECS::ReserveEntities(uint32_t capacity) {
+  if (capacity <= handles.size()) {
+    return;
+  }
+  capacity = std::min<size_t>(std::max<size_t>(capacity, 2 * handles.size()), MAX_ENTITY_NUMBER);
+  aliveAndComponentFlags.resize(capacity);
+  handles.reserve(capacity);
+  for (uint32_t index = uint32_t(handles.size()); index < capacity; index++) {
+    handles.push_back(index);
+  }
+}
+
 Entity ECS::DuplicateEntity(EntityId e) { return CopyFromOtherECS(e, this); }
 
 Entity ECS::CopyFromOtherECS(EntityId e, ECS const *otherECS) {
   EntityId newEntity = _CreateEntity();
-  for (int c = 0; c < componentArrays.size(); c++) {
-    if (otherECS->aliveAndComponentFlags[e] & (uint64_t(1) << c) && otherECS->componentArrays[c]) {
+  COMPONENT_BITS(otherECS->aliveAndComponentFlags[IndexOf(e)]).ForEachBit([&](size_t c) {
+    if (!componentArrays[c]) {
+      componentArrays[c] = otherECS->componentArrays[c]->InitEmptyForOtherECS(this);
+    }
+    // Constructors of components copied before may have attached this one already
+    if (!HasComponent(newEntity, c)) {
+      AddComponent(newEntity, c);
+    }
+    componentArrays[c]->CopyComponent(newEntity, otherECS->componentArrays[c], e);
+  });
+  if (!otherECS->IsActive(e)) {
+    SetActive(newEntity, false);
+  }
+  // Activity in the hierarchy depends on the parent, which copies of children only get afterwards
+  ENGINE_ASSERT((otherECS->aliveAndComponentFlags[IndexOf(e)] & ~ACTIVE_IN_HIERARCHY_FLAG) ==
+                    (aliveAndComponentFlags[IndexOf(newEntity)] & ~ACTIVE_IN_HIERARCHY_FLAG),
+                "Entity duplication failed!")
+  return Entity(newEntity, this);
+}
+
+void ECS::CloneFrom(ECS const *otherECS) {
+  aliveAndComponentFlags = otherECS->aliveAndComponentFlags;
+  handles = otherECS->handles;
+  aliveEntities = otherECS->aliveEntities;
+  activeEntities = otherECS->activeEntities;
+  activeInHierarchyEntities = otherECS->activeInHierarchyEntities;
+  firstFreeEntity = otherECS->firstFreeEntity;
+  unusedEntityIDs = otherECS->unusedEntityIDs;
+  version = otherECS->version;
+
+  std::vector<componentID> uncloned{};
+  for (componentID c = 0; c < componentArrays.size(); c++) {
+    if (otherECS->componentArrays[c]) {
+      delete componentArrays[c];
+      componentArrays[c] = otherECS->componentArrays[c]->CloneForOtherECS(this);
       if (!componentArrays[c]) {
         componentArrays[c] = otherECS->componentArrays[c]->InitEmptyForOtherECS(this);
+        uncloned.push_back(c);
       }
-      AddComponent(newEntity, c)->CopyFrom(otherECS->GetComponent(e, c));
     }
   }
-  ENGINE_ASSERT(otherECS->aliveAndComponentFlags[e] == aliveAndComponentFlags[newEntity], "Entity duplication failed!")
-  return Entity(newEntity, this);
+
+  // Components that can't be copy constructed are copied one by one, once all others are in place
+  for (componentID c : uncloned) {
+    otherECS->componentArrays[c]->Entities().ForEachSet([&](size_t index) {
+      componentArrays[c]->AddComponent(handles[index]);
+      componentArrays[c]->CopyComponent(handles[index], otherECS->componentArrays[c], handles[index]);
+    });
+  }
+
+  for (auto &[filterMask, query] : queries) {
+    ForEachMatchingIndex(filterMask,
+                         [&](size_t index) { query.Update(handles[index], aliveAndComponentFlags[index]); });
+  }
+  NotifyReset();
 }
 
 void ECS::Copy(ECS const *otherECS) {
-  EntityId current = 0;
-  while (current < otherECS->firstFreeEntity) {
-    while (!(otherECS->aliveAndComponentFlags[current] & ALIVE_FLAG) && ++current < otherECS->firstFreeEntity)
-      ;
-    if (HasComponent(current, ComponentID<HierarchyComponent>::value) &&
-        dynamic_cast<HierarchyComponent *>(otherECS->GetComponent(current, ComponentID<HierarchyComponent>::value))
-            ->parent) {
-      current++;
+  if (firstFreeEntity == 0) {
+    CloneFrom(otherECS);
+    return;
+  }
+
+  // Only roots are copied directly, children are copied along with them
+  uint32_t end = otherECS->firstFreeEntity;
+  for (size_t index = otherECS->aliveEntities.FindNext(0, end); index < end;
+       index = otherECS->aliveEntities.FindNext(index + 1, end)) {
+    EntityId e = otherECS->handles[index];
+    if (otherECS->HasComponent<HierarchyComponent>(e) &&
+        otherECS->GetComponentArray<HierarchyComponent>()->GetComponent(e)->parent.IsAlive()) {
       continue;
     }
-    CopyFromOtherECS(current++, otherECS);
+    CopyFromOtherECS(e, otherECS);
   }
 }
 
 void ECS::DestroyEntity(EntityId e) {
-  unusedEntityIDs.push(e);
-  for (int i = 0; i < componentArrays.size(); i++) {
-    if (aliveAndComponentFlags[e] & (uint64_t(1) << i)) {
-      componentArrays[i]->RemoveComponent(e);
-    }
+  if (!IsAlive(e)) {
+    ENGINE_ERROR("Tried to destroy dead entity!") return;
+  }
+  for (Observer *observer : observers) {
+    observer->OnDestroy(e);
+  }
+  // Children are left without a parent, so only their own activity counts from now on
+  std::vector<Entity> children{};
+  if (HasComponent<HierarchyComponent>(e)) {
+    children = GetComponentArray<HierarchyComponent>()->GetComponent(e)->children;
   }
+  // Every component is told first, so that none of them sees the others half removed
+  ComponentMask componentBits = COMPONENT_BITS(aliveAndComponentFlags[IndexOf(e)]);
+  componentBits.ForEachBit([&](size_t c) { componentArrays[c]->OnRemove(e); });
+  componentBits.ForEachBit([&](size_t c) { componentArrays[c]->RemoveComponent(e); });
   KILL(e)
+  UpdateQueries(e);
+  handles[IndexOf(e)] = NEXT_GENERATION(e);
+  unusedEntityIDs.push(IndexOf(e));
+  for (Entity const &child : children) {
+    if (IsAlive(child.id)) {
+      PropagateActivity(child.id);
+    }
+  }
+}
+
+void ECS::SetActive(EntityId e, bool active) {
+  if (!IsAlive(e)) {
+    ENGINE_ERROR("Tried to change activity of dead entity!") return;
+  }
+  if (active) {
+    aliveAndComponentFlags[IndexOf(e)].Set(ACTIVE_BIT);
+    activeEntities.Set(IndexOf(e));
+  } else {
+    aliveAndComponentFlags[IndexOf(e)].Clear(ACTIVE_BIT);
+    activeEntities.Clear(IndexOf(e));
+  }
+  UpdateQueries(e);
+  PropagateActivity(e);
+}
+
+void ECS::PropagateActivity(EntityId e) {
+  std::vector<EntityId> pending{e};
+  while (!pending.empty()) {
+    EntityId current = pending.back();
+    pending.pop_back();
+    ComponentMask &flags = aliveAndComponentFlags[IndexOf(current)];
+    HierarchyComponent const *hierarchy =
+        HasComponent<HierarchyComponent>(current) ? GetComponentArray<HierarchyComponent>()->GetComponent(current)
+                                                  : nullptr;
+    bool active = flags.Test(ACTIVE_BIT);
+    if (active && hierarchy && hierarchy->parent.parentECS == this && IsAlive(hierarchy->parent.id)) {
+      active = IsActiveInHierarchy(hierarchy->parent.id);
+    }
+    if (active == flags.Test(ACTIVE_IN_HIERARCHY_BIT)) {
+      continue; // Children only depend on the parent's flag, which is unchanged
+    }
+
+    if (active) {
+      flags.Set(ACTIVE_IN_HIERARCHY_BIT);
+      activeInHierarchyEntities.Set(IndexOf(current));
+    } else {
+      flags.Clear(ACTIVE_IN_HIERARCHY_BIT);
+      activeInHierarchyEntities.Clear(IndexOf(current));
+    }
+    UpdateQueries(current);
+    if (hierarchy) {
+      for (Entity const &child : hierarchy->children) {
+        if (child.parentECS == this && IsAlive(child.id)) {
+          pending.push_back(child.id);
+        }
+      }
+    }
+  }
+}
+
+ECS::MemoryReport ECS::GetMemoryReport() const {
+  MemoryReport report{
+      .entityBytes = sizeof(ECS) + aliveAndComponentFlags.capacity() * sizeof(ComponentMask) +
+                     handles.capacity() * sizeof(EntityId) + unusedEntityIDs.size() * sizeof(uint32_t) +
+                     aliveEntities.MemoryUsage() + activeEntities.MemoryUsage() +
+                     activeInHierarchyEntities.MemoryUsage(),
+      .indexMapBytes = 0,
+      .componentBytes = 0,
+      .queryBytes = 0};
+  for (ComponentArray const *array : componentArrays) {
+    if (array) {
+      report.indexMapBytes += array->IndexMapBytes();
+      report.componentBytes += array->ComponentBytes();
+    }
+  }
+  for (auto const &[_, query] : queries) {
+    report.queryBytes += sizeof(query) + query.matches.capacity() * sizeof(EntityId) +
+                         query.positions.capacity() * sizeof(uint32_t);
+  }
+  return report;
+}
+
+ECSCommandBuffer &ECS::Commands() {
+  // Keyed by serial rather than address, as a new ECS may reuse the address of a destroyed one
+  thread_local std::unordered_map<uint64_t, ECSCommandBuffer *> threadBuffers{};
+  ECSCommandBuffer *&buffer = threadBuffers[serial];
+  if (!buffer) {
+    std::lock_guard lock(commandBufferMutex);
+    buffer = commandBuffers.emplace_back(std::make_unique<ECSCommandBuffer>()).get();
+  }
+  return *buffer;
+}
+
+bool ECS::PlaybackCommands() {
+  // Commands recorded during playback (e.g. by constructors) go to the emptied buffers and wait for the next one
+  ECSCommandBuffer pending{};
+  {
+    std::lock_guard lock(commandBufferMutex);
+    for (auto &buffer : commandBuffers) {
+      pending.Append(std::move(*buffer));
+    }
+  }
+  if (pending.Empty()) {
+    return false;
+  }
+  pending.Playback(this);
+  return true;
+}
+
+void ECS::Reset() {
+  for (ComponentArray *&array : componentArrays) {
+    delete array;
+    array = nullptr;
+  }
+  aliveAndComponentFlags.assign(INITIAL_ENTITY_CAPACITY, ComponentMask());
+  handles.resize(INITIAL_ENTITY_CAPACITY);
+  for (uint32_t index = 0; index < handles.size(); index++) {
+    handles[index] = index;
+  }
+  aliveEntities = Util::Bitmap();
+  activeEntities = Util::Bitmap();
+  activeInHierarchyEntities = Util::Bitmap();
+  firstFreeEntity = 0;
+  unusedEntityIDs = std::stack<uint32_t>();
+  for (auto &[_, query] : queries) {
+    query.matches.clear();
+    query.positions.clear();
+  }
+  NotifyReset();
+}
+
+void ECS::NotifyReset() {
+  for (Observer *observer : observers) {
+    observer->OnReset();
+  }
+}
+
+// Tagged entities are written by handle
+bool ECS::TagArray::Snapshot(SnapshotWriter &writer) const {
+  writer.Write(uint32_t(entities.Count()));
+  entities.ForEachSet([&](size_t index) { writer.Write(parent->handles[index]); });
+  return true;
+}
+
+bool ECS::TagArray::Restore(SnapshotReader &reader) {
+  uint32_t count = 0;
+  reader.Read(count);
+  if (reader.Failed() || count > parent->firstFreeEntity) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    EntityId e = EntityId(-1);
+    reader.Read(e);
+    if (reader.Failed() || !parent->HasComponent(e, id) || entities.Test(IndexOf(e))) {
+      return false;
+    }
+    entities.Set(IndexOf(e));
+  }
+  return true;
+}
+
+size_t ECS::Snapshot(std::span<std::byte> buffer) const {
+  SnapshotWriter writer(buffer, this);
+  writer.Write(uint32_t(SNAPSHOT_MAGIC), uint32_t(sizeof(ComponentMask)), firstFreeEntity, version);
+  writer.WriteRaw(aliveAndComponentFlags.data(), firstFreeEntity);
+  writer.WriteRaw(handles.data(), firstFreeEntity);
+
+  std::vector<uint32_t> freeSlots(unusedEntityIDs.size());
+  auto unused = unusedEntityIDs;
+  for (auto slot = freeSlots.rbegin(); slot != freeSlots.rend(); slot++) { // Bottom of the stack first
+    *slot = unused.top();
+    unused.pop();
+  }
+  writer.Write(freeSlots);
+
+  for (componentID c = 0; c < componentArrays.size(); c++) {
+    if (componentArrays[c]) {
+      writer.Write(c);
+      if (!componentArrays[c]->Snapshot(writer)) {
+        ENGINE_WARNING("Tried to snapshot component type {} without Serialize function!", c) return 0;
+      }
+    }
+  }
+  writer.Write(componentID(-1));
+  if (writer.Failed()) {
+    ENGINE_WARNING("Tried to snapshot a reference to an entity in another ECS!") return 0;
+  }
+  return writer.Size();
+}
+
+bool ECS::Restore(std::span<std::byte const> snapshot) {
+  Reset();
+  SnapshotReader reader(snapshot, this);
+  uint32_t magic = 0, maskBytes = 0, entityCount = 0, snapshotVersion = 0;
+  reader.Read(magic, maskBytes, entityCount, snapshotVersion);
+  if (reader.Failed() || magic != SNAPSHOT_MAGIC || maskBytes != sizeof(ComponentMask) ||
+      entityCount > MAX_ENTITY_NUMBER) {
+    ENGINE_WARNING("Tried to restore ECS from invalid snapshot!") return false;
+  }
+
+  ReserveEntities(entityCount);
+  reader.ReadRaw(aliveAndComponentFlags.data(), entityCount);
+  reader.ReadRaw(handles.data(), entityCount);
+  firstFreeEntity = entityCount;
+  version = snapshotVersion;
+  for (uint32_t index = 0; index < entityCount; index++) {
+    if (aliveAndComponentFlags[index].Test(ALIVE_BIT)) {
+      // Handles are used as entity IDs from here on, so each has to name its own slot
+      if (IndexOf(handles[index]) != index) {
+        ENGINE_WARNING("Snapshot stores a handle of entity {} in slot {}!", IndexOf(handles[index]), index)
+        Reset();
+        return false;
+      }
+      aliveEntities.Set(index);
+      if (aliveAndComponentFlags[index].Test(ACTIVE_BIT)) {
+        activeEntities.Set(index);
+      }
+      if (aliveAndComponentFlags[index].Test(ACTIVE_IN_HIERARCHY_BIT)) {
+        activeInHierarchyEntities.Set(index);
+      }
+    }
+  }
+
+  std::vector<uint32_t> freeSlots{};
+  reader.Read(freeSlots);
+  for (uint32_t slot : freeSlots) {
+    if (slot >= entityCount || aliveEntities.Test(slot)) {
+      ENGINE_WARNING("Snapshot lists entity {} as both alive and free!", slot)
+      Reset();
+      return false;
+    }
+    unusedEntityIDs.push(slot);
+  }
+
+  componentID c = componentID(-1);
+  reader.Read(c);
+  while (!reader.Failed() && c != componentID(-1)) {
+    if (c >= nextComponentID || componentArrays[c]) {
+      ENGINE_WARNING("Snapshot contains unknown component type {}!", c)
+      Reset();
+      return false;
+    }
+    componentArrays[c] = poolFactories[c](this);
+    if (!componentArrays[c]->Restore(reader)) {
+      ENGINE_WARNING("Failed to restore components of type {}!", c)
+      Reset();
+      return false;
+    }
+    reader.Read(c);
+  }
+  if (reader.Failed()) {
+    ENGINE_WARNING("Tried to restore ECS from truncated snapshot!")
+    Reset();
+    return false;
+  }
+
+  // Pools only accept entities with their bit set, so matching counts mean that every bit is backed by a component
+  std::array<uint32_t, MAX_COMPONENT_NUMBER> bitCounts{};
+  aliveEntities.ForEachSet([&](size_t index) {
+    COMPONENT_BITS(aliveAndComponentFlags[index]).ForEachBit([&](size_t c) { bitCounts[c]++; });
+  });
+  for (componentID c = 0; c < componentArrays.size(); c++) {
+    if (bitCounts[c] != (componentArrays[c] ? componentArrays[c]->Entities().Count() : 0)) {
+      ENGINE_WARNING("Snapshot marks entities with component type {} that it has no components for!", c)
+      Reset();
+      return false;
+    }
+  }
+
+  for (auto &[filterMask, query] : queries) {
+    ForEachMatchingIndex(filterMask,
+                         [&](size_t index) { query.Update(handles[index], aliveAndComponentFlags[index]); });
+  }
+  NotifyReset();
+  return true;
+}
+
+void SnapshotWriter::Write(Entity const &entity) {
+  if (!entity.parentECS) {
+    Write(uint8_t(ENTITY_IN_NO_ECS));
+  } else if (entity.parentECS == ecs) {
+    Write(uint8_t(ENTITY_IN_SNAPSHOT), entity.id);
+  } else {
+    // Another ECS can only be identified by its address, which must never be read back from a snapshot
+    Write(uint8_t(ENTITY_IN_NO_ECS));
+    failed = true;
+  }
+}
+
+void SnapshotReader::Read(Entity &entity) {
+  uint8_t owner = ENTITY_IN_NO_ECS;
+  Read(owner);
+  if (owner == ENTITY_IN_NO_ECS) {
+    entity = Entity();
+  } else if (owner == ENTITY_IN_SNAPSHOT) {
+    entity.parentECS = ecs;
+    Read(entity.id);
+  } else {
+    failed = true;
+  }
 }
 
 void _CopyError(const char * typeName) {
@@ -116,14 +595,14 @@ void _CopyError(const char * typeName) {
 
 std::vector<Component *> ECS::GetComponents(EntityId e) const {
   std::vector<Component *> result;
-  if (e == EntityId(-1) || !(aliveAndComponentFlags[e] & ALIVE_FLAG)) {
+  if (!IsAlive(e)) {
     return result;
   }
-  for (int i = 0; i < componentArrays.size(); i++) {
-    if (aliveAndComponentFlags[e] & (uint64_t(1) << i) && componentArrays[i]) {
-      result.push_back(componentArrays[i]->GetComponent(e));
+  COMPONENT_BITS(aliveAndComponentFlags[IndexOf(e)]).ForEachBit([&](size_t c) {
+    if (Component *component = componentArrays[c]->GetComponent(e)) { // Tags have none
+      result.push_back(component);
     }
-  }
+  });
   return result;
 }
 
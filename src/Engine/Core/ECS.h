@@ -1,70 +1,262 @@
 #pragma once
 
+#include "Core/ComponentMask.h"
+#include "Core/Snapshot.h"
+#include "Util/AlignedAllocator.h"
+#include "Util/Bitmap.h"
 #include "Util/Macros.h"
+#include "Util/PagedArray.h"
+#include "Util/ThreadPool.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <inttypes.h>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <stack>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
-#define MAX_COMPONENT_NUMBER 60
-#define MAX_ENTITY_NUMBER (1 << 16)
-#define ALIVE_FLAG (uint64_t(1) << 63)
-#define ACTIVE_FLAG (uint64_t(1) << 62)
-#define COMPONENT_FLAG(ComponentType) (uint64_t(1) << ComponentID<ComponentType>::value)
+#define MAX_COMPONENT_NUMBER (ComponentMask::BIT_COUNT - 3) // The three highest bits of a mask are the entity flags
+#define ALIVE_BIT (MAX_COMPONENT_NUMBER + 2)
+#define ACTIVE_BIT (MAX_COMPONENT_NUMBER + 1)
+#define ACTIVE_IN_HIERARCHY_BIT MAX_COMPONENT_NUMBER // Active, as are all parents
+#define ALIVE_FLAG ComponentMask::Bit(ALIVE_BIT)
+#define ACTIVE_FLAG ComponentMask::Bit(ACTIVE_BIT)
+#define ACTIVE_IN_HIERARCHY_FLAG ComponentMask::Bit(ACTIVE_IN_HIERARCHY_BIT)
+#define COMPONENT_FLAG(ComponentType) ComponentMask::Bit(ComponentID<ComponentType>::value)
+#define ENTITY_INDEX_BITS 20 // The bits above the index count how often the slot of an entity has been reused
+#define MAX_ENTITY_NUMBER ((1 << ENTITY_INDEX_BITS) - 1) // The highest index is left to EntityId(-1)
+#define INITIAL_ENTITY_CAPACITY 64
+#define INDEX_MAP_PAGE_BITS 8 // Index maps are allocated in pages of 256 entities
+#define PARALLEL_CHUNK_BYTES (1 << 15) // Default chunks of ParallelForEach should fit into L1
 
 namespace Engine::Core {
-using EntityId = uint16_t;
+using EntityId = uint32_t; // Generational handle, see IndexOf
 using componentID = uint8_t;
-using ComponentIndex = uint16_t; // Should be the same size as EntityId
+// Every bit of a mask, flags included, needs an ID below componentID(-1), which marks unregistered types
+static_assert(ComponentMask::BIT_COUNT <= std::numeric_limits<componentID>::max(),
+              "COMPONENT_MASK_WORDS is too large for componentID");
+using ComponentIndex = uint32_t; // Should be the same size as EntityId
+
+inline constexpr uint32_t IndexOf(EntityId e) { return e & ((uint32_t(1) << ENTITY_INDEX_BITS) - 1); }
 
 template <typename T> struct ComponentID {
   inline static componentID value = componentID(-1);
 };
 
+// Tags are empty types that only mark entities, e.g. struct Static {}. They have no instances and thus no component
+// storage, just their bit in the masks (and in the bitmap the filters intersect).
+template <class T>
+concept TagComponent = std::is_empty_v<T>;
+
+// Additionally required components or tags of a filter, which are matched but not fetched
+template <class... Ts> struct With {};
+
+// Filters entities that are active and only have active parents, e.g. With<ActiveInHierarchy>(). Unlike a tag, it
+// can't be added or removed, SetActive and reparenting keep it up to date.
+struct ActiveInHierarchy {};
+template <> struct ComponentID<ActiveInHierarchy> {
+  static constexpr componentID value = ACTIVE_IN_HIERARCHY_BIT;
+};
+
 class Component;
 class Entity;
+class ECSCommandBuffer;
 
 class ECS {
+public:
+  class Observer;
+
 private:
+  friend class ECSCommandBuffer;
+
   class ComponentArray {
   protected:
-    std::array<ComponentIndex, MAX_ENTITY_NUMBER> entityComponentIndexMap;
+    Util::PagedArray<ComponentIndex, INDEX_MAP_PAGE_BITS> entityComponentIndexMap; // Indexed by IndexOf(entity)
+    Util::Bitmap entities; // Indices of the entities that have the component
     ECS *parent;
 
   public:
-    inline ComponentArray(ECS *parent) : parent(parent) {}
+    inline ComponentArray(ECS *parent) : entityComponentIndexMap(), entities(), parent(parent) {}
     virtual Component *GetComponent(EntityId e) = 0;
     virtual Component *AddComponent(EntityId e) = 0;
     virtual void RemoveComponent(EntityId e) = 0;
+    // Called before the component of e is removed, while e and all its components are still attached
+    virtual void OnRemove(EntityId e) = 0;
     virtual ComponentArray *InitEmptyForOtherECS(ECS *otherECS) const = 0;
+    // Copies the whole pool for otherECS, which has to be a clone of the parent ECS. nullptr if C is not copyable.
+    virtual ComponentArray *CloneForOtherECS(ECS *otherECS) const = 0;
+    // Copies the component of sourceEntity in source (of the same type) onto the already attached one of e
+    virtual void CopyComponent(EntityId e, ComponentArray const *source, EntityId sourceEntity) = 0;
+    virtual size_t ComponentBytes() const = 0;
+    // Write or read the whole pool, false if C has no Serialize or Deserialize function
+    virtual bool Snapshot(SnapshotWriter &writer) const = 0;
+    virtual bool Restore(SnapshotReader &reader) = 0;
+    inline size_t IndexMapBytes() const { return entityComponentIndexMap.MemoryUsage() + entities.MemoryUsage(); }
+    inline Util::Bitmap const &Entities() const { return entities; }
     virtual ~ComponentArray() {}
   };
 
-  template <class C> class ComponentArrayT : public ComponentArray {
-    std::vector<C *> components;
+  // Components are stored by value and packed densely (removal swaps the last component into the gap), so pointers
+  // to components are only valid until the next structural change of their pool. Use Entity as a stable handle.
+  template <class C> class ComponentArrayT final : public ComponentArray {
+    std::vector<C, Util::AlignedAllocator<C>> components;
+    std::vector<uint32_t> versions; // ECS version of the last change, per component
+    uint32_t version;               // ECS version of the last change of any component
 
   public:
-    inline ComponentArrayT(ECS *parent) : ComponentArray(parent) {}
-    ~ComponentArrayT();
+    inline ComponentArrayT(ECS *parent) : ComponentArray(parent), components(), versions(), version(0) {}
     C *GetComponent(EntityId e);
+    inline C const *GetComponent(EntityId e) const { return &components[entityComponentIndexMap[IndexOf(e)]]; }
     C *AddComponent(EntityId e);
     void RemoveComponent(EntityId e);
+    // C may react to being removed through an OnRemove function (e.g. to invalidate caches depending on it)
+    inline void OnRemove(EntityId e) override {
+      if constexpr (requires(C &component) { component.OnRemove(); }) {
+        components[entityComponentIndexMap[IndexOf(e)]].OnRemove();
+      }
+    }
     inline ComponentArray *InitEmptyForOtherECS(ECS *otherECS) const override {
       return new ComponentArrayT<C>(otherECS);
     }
+    ComponentArray *CloneForOtherECS(ECS *otherECS) const override;
+    void CopyComponent(EntityId e, ComponentArray const *source, EntityId sourceEntity) override;
+    inline size_t ComponentBytes() const override {
+      return sizeof(*this) + components.capacity() * sizeof(C) + versions.capacity() * sizeof(uint32_t);
+    }
+    bool Snapshot(SnapshotWriter &writer) const override;
+    bool Restore(SnapshotReader &reader) override;
+    // C may react to being marked through an OnChanged function (e.g. to invalidate caches)
+    inline void MarkChanged(EntityId e) {
+      ComponentIndex index = entityComponentIndexMap[IndexOf(e)];
+      versions[index] = version = parent->version;
+      if constexpr (requires(C &component) { component.OnChanged(); }) {
+        components[index].OnChanged();
+      }
+    }
+    inline uint32_t Version() const { return version; }
+    inline uint32_t Version(size_t index) const { return versions[index]; }
+    inline C &operator[](size_t index) { return components[index]; }
+
+    inline size_t Size() const { return components.size(); }
+    inline void Reserve(size_t additional) {
+      if (components.size() + additional > components.capacity()) {
+        components.reserve(std::max(components.size() + additional, 2 * components.capacity()));
+      }
+    }
+    inline auto begin() { return components.begin(); }
+    inline auto end() { return components.end(); }
+  };
+
+  // Pool of a tag, which only consists of the bitmap of tagged entities
+  class TagArray final : public ComponentArray {
+    componentID id;
+
+  public:
+    inline TagArray(ECS *parent, componentID id) : ComponentArray(parent), id(id) {}
+    inline Component *GetComponent(EntityId) override { return nullptr; }
+    inline Component *AddComponent(EntityId e) override {
+      entities.Set(IndexOf(e));
+      return nullptr;
+    }
+    inline void RemoveComponent(EntityId e) override { entities.Clear(IndexOf(e)); }
+    inline void OnRemove(EntityId) override {}
+    inline ComponentArray *InitEmptyForOtherECS(ECS *otherECS) const override { return new TagArray(otherECS, id); }
+    inline ComponentArray *CloneForOtherECS(ECS *otherECS) const override {
+      auto clone = new TagArray(*this);
+      clone->parent = otherECS;
+      return clone;
+    }
+    inline void CopyComponent(EntityId, ComponentArray const *, EntityId) override {}
+    inline size_t ComponentBytes() const override { return sizeof(*this); }
+    bool Snapshot(SnapshotWriter &writer) const override;
+    bool Restore(SnapshotReader &reader) override;
   };
 
-  std::vector<uint64_t> aliveAndComponentFlags;
-  EntityId firstFreeEntity;
-  std::stack<EntityId> unusedEntityIDs;
+  // Entities matching one filter mask, kept up to date on every structural change so that iterating a query only
+  // costs the matches themselves
+  struct CachedQuery {
+    ComponentMask filterMask;
+    std::vector<EntityId> matches;
+    std::vector<uint32_t> positions; // Index into matches per entity index
+
+    CachedQuery(ComponentMask filterMask) : filterMask(filterMask), matches(), positions() {}
+    void Update(EntityId e, ComponentMask const &flags);
+  };
+
+  // Both indexed by IndexOf(entity). Destroying an entity changes the generation of its handle, so that handles kept
+  // from before are recognised as dead even once the index has been reused.
+  std::vector<ComponentMask> aliveAndComponentFlags;
+  std::vector<EntityId> handles;
+  // Mirror the entity flags, so that iterating entities and matching filters can skip 64 indices at a time
+  Util::Bitmap aliveEntities;
+  Util::Bitmap activeEntities;            // Alive and active
+  Util::Bitmap activeInHierarchyEntities; // Alive, active and with active parents
+  std::unordered_map<ComponentMask, CachedQuery, ComponentMask::Hash> queries;
+  std::mutex queryMutex; // Concurrent systems may create queries, structural changes never run alongside them
+  uint32_t firstFreeEntity;
+  std::stack<uint32_t> unusedEntityIDs;
   std::array<ComponentArray *, MAX_COMPONENT_NUMBER> componentArrays;
+  uint32_t version;
+  uint64_t serial; // Unique per ECS, identifies it in the thread-local command buffers
+  std::vector<std::unique_ptr<ECSCommandBuffer>> commandBuffers;
+  std::mutex commandBufferMutex;
   inline static componentID nextComponentID = 0;
+  inline static std::array<ComponentArray *(*)(ECS *), MAX_COMPONENT_NUMBER> poolFactories{}; // By component ID
+  inline static std::mutex registrationMutex; // Guards the two above, ECSs on other threads may register concurrently
+  std::vector<Observer *> observers;            // Outlives the resources, which may be observers themselves
+  std::vector<std::shared_ptr<void>> resources; // Indexed by ResourceIndex
+  inline static std::atomic<uint32_t> nextResourceIndex = 0;
+
+  template <class R> static inline uint32_t ResourceIndex() {
+    static const uint32_t index = nextResourceIndex++;
+    return index;
+  }
+
+  static componentID NextComponentID();
+
+  // Indices past the end (e.g. of EntityId(-1)) are clamped to the last slot, whose handle can't match them. This
+  // keeps lookups by handle free of branches.
+  inline uint32_t SlotOf(EntityId e) const { return std::min<uint32_t>(IndexOf(e), uint32_t(handles.size() - 1)); }
+
+  template <class C> inline ComponentArrayT<C> *GetComponentArray() const {
+    static_assert(!TagComponent<C>, "Tags have no components, use AddTag, HasTag and RemoveTag instead.");
+    return static_cast<ComponentArrayT<C> *>(componentArrays[ComponentID<C>::value]);
+  }
+  template <class C> inline ComponentArrayT<C> *GetOrCreateComponentArray() {
+    if (!componentArrays[ComponentID<C>::value]) {
+      componentArrays[ComponentID<C>::value] = new ComponentArrayT<C>(this);
+    }
+    return GetComponentArray<C>();
+  }
+
+  void ReserveEntities(uint32_t capacity);
+
+  // Report why a component can't be attached to or accessed on e
+  bool CanAddComponent(EntityId e, ComponentIndex componentIndex) const;
+  bool CanAccessComponent(EntityId e, ComponentIndex componentIndex) const;
 
   Component *AddComponent(EntityId e, ComponentIndex componentIndex);
   Component *GetComponent(EntityId e, ComponentIndex componentIndex) const;
-  bool HasComponent(EntityId e, ComponentIndex componentIndex) const;
-  void RemoveComponent(EntityId e, ComponentIndex componentIndex);
+  inline bool HasComponent(EntityId e, ComponentIndex componentIndex) const;
+
+  void CloneFrom(ECS const *otherECS);
+  void Reset(); // Removes all entities and pools
+  void NotifyReset();
+
+  // Safe to call from concurrent systems, the matches of a query are stable until the next structural change
+  CachedQuery &GetCachedQuery(ComponentMask filterMask);
+  // Calls fn(index) for every entity index whose flags contain filterMask, by intersecting the entity and pool bitmaps
+  template <typename Fn> inline void ForEachMatchingIndex(ComponentMask const &filterMask, Fn const &fn) const;
+  void UpdateQueries(EntityId e);
+  // Recalculates whether e and its children are active in the hierarchy, skipping subtrees that stay the same
+  void PropagateActivity(EntityId e);
 
 public:
   ECS();
@@ -72,24 +264,93 @@ public:
 
   EntityId _CreateEntity();
   inline Entity CreateEntity();
+  std::vector<EntityId> CreateEntities(uint32_t count);
   Entity DuplicateEntity(EntityId e);
   inline Entity DuplicateEntity(Entity e);
   void DestroyEntity(EntityId e);
   inline void DestroyEntity(Entity e);
 
-  template <class C> static void RegisterComponent(); // Components can only be registered after initialization
+  // Components can only be registered after initialization. Registering is thread-safe, but a type has to be
+  // registered before any ECS uses it.
+  template <class C> static void RegisterComponent();
 
   template <class C> inline C *AddComponent(EntityId e);
+  // Attaches all of Cs to every entity, reserving the pools once. Components are constructed in the order of Cs.
+  template <class... Cs> inline void AddComponents(std::span<EntityId const> entities);
   template <class C> inline C *GetComponent(EntityId e) const;
   template <class C> inline bool HasComponent(EntityId e) const;
   template <class C> inline void RemoveComponent(EntityId e);
-  inline void SetActive(EntityId e, bool active);
+  template <TagComponent T> inline void AddTag(EntityId e);
+  template <TagComponent T> inline bool HasTag(EntityId e) const { return HasComponent<T>(e); }
+  template <TagComponent T> inline void RemoveTag(EntityId e);
+  void SetActive(EntityId e, bool active);
   inline bool IsActive(EntityId e) const;
+  inline bool IsActiveInHierarchy(EntityId e) const;
   inline bool IsAlive(EntityId e) const;
+  inline EntityId HandleAt(EntityId e) const { return handles[SlotOf(e)]; } // Current handle at the index of e
 
   std::vector<Component *> GetComponents(EntityId e) const;
 
-  template <class... Cs> std::vector<std::tuple<Cs *...>> FilterEntities(bool onlyActive = true);
+  // Added and copied components count as changed, other changes have to be marked (or made through ModifyComponent).
+  // Changes are stamped with the current version, which the game advances once per frame.
+  template <class C> inline void MarkChanged(EntityId e);
+  template <class C> inline C *ModifyComponent(EntityId e);
+  inline uint32_t Version() const { return version; }
+  inline uint32_t AdvanceVersion() { return version++; } // Returns the version changes were stamped with until now
+  // Like FilterEntities, restricted to entities whose C changed after version since. Pools without changes since
+  // then are skipped right away.
+  template <class C, class... Cs>
+  std::vector<std::tuple<C *, Cs *...>> Changed(uint32_t since, bool onlyActive = true);
+
+  template <class... Cs, class... Ts>
+  std::vector<std::tuple<Cs *...>> FilterEntities(With<Ts...>, bool onlyActive = true);
+  template <class... Cs> inline std::vector<std::tuple<Cs *...>> FilterEntities(bool onlyActive = true) {
+    return FilterEntities<Cs...>(With<>(), onlyActive);
+  }
+  // Entities with all of Ts, which are usually tags
+  template <class... Ts> std::vector<Entity> EntitiesWith(bool onlyActive = true);
+
+  // Persistent alternative to FilterEntities, meant for queries that run every frame
+  template <class... Cs> class QueryView;
+  template <class... Cs, class... Ts> inline QueryView<Cs...> Query(With<Ts...>, bool onlyActive = true);
+  template <class... Cs> inline QueryView<Cs...> Query(bool onlyActive = true) {
+    return Query<Cs...>(With<>(), onlyActive);
+  }
+
+  // Calls fn(Cs *...), or fn(matchIndex, Cs *...), for every match, split into chunks of grainSize entities which are
+  // run on the shared thread pool. Chunk boundaries only depend on the match order and the grain size (by default,
+  // as many entities as fit into L1). fn must not change the structure of the ECS.
+  template <class... Cs, typename Fn, class... Ts>
+  inline void ParallelForEach(Fn const &fn, With<Ts...>, size_t grainSize = 0, bool onlyActive = true);
+  template <class... Cs, typename Fn>
+  inline void ParallelForEach(Fn const &fn, size_t grainSize = 0, bool onlyActive = true) {
+    ParallelForEach<Cs...>(fn, With<>(), grainSize, onlyActive);
+  }
+
+  // Per-ECS singletons (e.g. light settings) that belong to no entity. Emplacing replaces the current resource of
+  // type R. Resources are neither copied along with entities nor part of snapshots.
+  template <class R, typename... Args> inline R *EmplaceResource(Args &&...args);
+  template <class R> inline R *GetResource() const; // nullptr if there is none
+  template <class R> inline void RemoveResource();
+
+  // Told about entities entering and leaving the ECS and about changed parents, so that views of the ECS (e.g.
+  // SceneHierarchy) can be maintained incrementally. Replacing the whole contents (cloning, restoring) calls OnReset.
+  class Observer {
+  public:
+    virtual void OnCreate(EntityId e) = 0;
+    virtual void OnDestroy(EntityId e) = 0; // While e and its components are still alive
+    virtual void OnParentChange(EntityId e) = 0;
+    virtual void OnReset() = 0;
+    virtual ~Observer() {}
+  };
+  inline void AddObserver(Observer *observer) { observers.push_back(observer); }
+  inline void RemoveObserver(Observer *observer) { std::erase(observers, observer); }
+  inline void NotifyParentChange(EntityId e) {
+    PropagateActivity(e);
+    for (Observer *observer : observers) {
+      observer->OnParentChange(e);
+    }
+  }
 
   class EntityIterator;
   friend class EntityIterator;
@@ -97,14 +358,44 @@ public:
   EntityIterator begin();
   EntityIterator end();
 
+  // Command buffer of the calling thread, for structural changes that have to wait until the next sync point
+  ECSCommandBuffer &Commands();
+  // Plays back the command buffers of all threads. Returns whether there were any commands.
+  bool PlaybackCommands();
+
   Entity CopyFromOtherECS(EntityId e, ECS const *otherECS);
+  // Copies all root entities (with their children) of otherECS. An empty ECS becomes a clone with the same handles
+  // instead, which copies whole pools rather than single components.
   void Copy(ECS const *otherECS);
+
+  struct MemoryReport {
+    size_t entityBytes;    // The ECS itself, masks, handles and free slots
+    size_t indexMapBytes;  // Entity to component index maps of all pools
+    size_t componentBytes; // Component pools, including their spare capacity
+    size_t queryBytes;     // Cached queries
+    inline size_t Total() const { return entityBytes + indexMapBytes + componentBytes + queryBytes; }
+  };
+  MemoryReport GetMemoryReport() const;
+
+  // Writes entities, flags, free slots and all pools to buffer and returns the size of the snapshot, which is only
+  // complete if it fits into buffer (so an empty buffer can be used to measure it). Returns 0 if a pool can't be
+  // written (see ComponentArray::Snapshot) or a component refers to an entity in another ECS.
+  size_t Snapshot(std::span<std::byte> buffer) const;
+  // Replaces the contents of the ECS with a snapshot. Component types have to be registered in the same order as when
+  // it was taken. Restored components are constructed in the order of their IDs and then deserialized. Snapshots may
+  // come from outside (e.g. over the network), so a malformed one only logs a warning, empties the ECS and returns
+  // false.
+  bool Restore(std::span<std::byte const> snapshot);
 };
 
 class Entity { // Wrapper for internal entity, convenience only
   EntityId id;
   friend class ECS;
+  friend class ECSCommandBuffer;
   friend class HierarchyComponent;
+  friend class SceneHierarchy;
+  friend class SnapshotWriter;
+  friend class SnapshotReader;
   ECS *parentECS;
 
 public:
@@ -115,36 +406,84 @@ public:
   template <class C> inline C *GetComponent() const { return parentECS->GetComponent<C>(id); }
   template <class C> inline bool HasComponent() const { return parentECS->HasComponent<C>(id); }
   template <class C> inline void RemoveComponent() const { parentECS->RemoveComponent<C>(id); }
+  template <TagComponent T> inline void AddTag() const { parentECS->AddTag<T>(id); }
+  template <TagComponent T> inline bool HasTag() const { return parentECS->HasTag<T>(id); }
+  template <TagComponent T> inline void RemoveTag() const { parentECS->RemoveTag<T>(id); }
+  template <class C> inline void MarkChanged() const { parentECS->MarkChanged<C>(id); }
+  template <class C> inline C *ModifyComponent() const { return parentECS->ModifyComponent<C>(id); }
 
   inline std::vector<Component *> GetComponents() const { return parentECS->GetComponents(id); }
   inline void Destroy() const { parentECS->DestroyEntity(id); }
+  inline ECSCommandBuffer &Commands() const { return parentECS->Commands(); }
   inline bool IsAlive() const { return parentECS && parentECS->IsAlive(id); }
   inline void SetActive(bool active = true) const { parentECS->SetActive(id, active); }
   inline bool IsActive() const { return parentECS->IsActive(id); }
+  inline bool IsActiveInHierarchy() const { return parentECS->IsActiveInHierarchy(id); }
+  // For code that assigns HierarchyComponent::parent directly instead of through SetParent
+  inline void NotifyParentChange() const { parentECS->NotifyParentChange(id); }
 
   inline bool operator==(Entity const &other) const { return id == other.id && parentECS == other.parentECS; }
+  // Moves the handle over to a clone of its ECS, in which entities keep their handles
+  inline void Rebind(ECS const *from, ECS *to) {
+    if (parentECS == from) {
+      parentECS = to;
+    }
+  }
 
   inline Entity Duplicate() const { return parentECS->DuplicateEntity(id); }
   inline Entity CopyToOtherECS(ECS *otherECS) const { return otherECS->CopyFromOtherECS(id, parentECS); }
-  inline Entity InOtherECS(ECS *otherECS) const { return Entity(id, otherECS); }
+  inline Entity InOtherECS(ECS *otherECS) const { return Entity(otherECS->HandleAt(id), otherECS); }
 };
 
 class ECS::EntityIterator {
-  EntityId currentEntity = 0;
+  uint32_t currentEntity = 0;
   ECS *ecs;
 
 public:
-  inline Entity operator*() const { return Entity(currentEntity, ecs); }
+  inline Entity operator*() const { return Entity(ecs->handles[currentEntity], ecs); }
   inline EntityIterator &operator++() {
-    while (!(ecs->aliveAndComponentFlags[++currentEntity] & ALIVE_FLAG) && currentEntity < ecs->firstFreeEntity)
-      ;
+    currentEntity = uint32_t(ecs->aliveEntities.FindNext(currentEntity + 1, ecs->firstFreeEntity));
     return *this;
   }
 
   inline bool operator==(EntityIterator const &other) const { return currentEntity == other.currentEntity; }
   inline bool operator!=(EntityIterator const &other) const { return currentEntity != other.currentEntity; }
 
-  EntityIterator(EntityId e, ECS *ecs) : currentEntity(e), ecs(ecs) {}
+  EntityIterator(uint32_t index, ECS *ecs) : currentEntity(index), ecs(ecs) {}
+};
+
+template <class... Cs> class ECS::QueryView {
+  ECS *ecs;
+  std::vector<EntityId> const *matches;
+
+public:
+  struct Sentinel {};
+
+  class Iterator {
+    ECS *ecs;
+    std::vector<EntityId> const *matches;
+    size_t index;
+
+  public:
+    Iterator(ECS *ecs, std::vector<EntityId> const *matches) : ecs(ecs), matches(matches), index(0) {}
+    inline std::tuple<Cs *...> operator*() const {
+      EntityId e = (*matches)[index];
+      return std::make_tuple(ecs->GetComponentArray<Cs>()->GetComponent(e)...);
+    }
+    inline Iterator &operator++() {
+      ++index;
+      return *this;
+    }
+    // Compared by size, as the matches can change while iterating
+    inline bool operator!=(Sentinel const &) const { return index < matches->size(); }
+  };
+
+  QueryView(ECS *ecs, std::vector<EntityId> const *matches) : ecs(ecs), matches(matches) {}
+
+  inline Iterator begin() const { return Iterator(ecs, matches); }
+  inline Sentinel end() const { return Sentinel{}; }
+  inline size_t Size() const { return matches->size(); }
+  inline bool Empty() const { return matches->empty(); }
 };
 
 class Component {
@@ -178,83 +517,350 @@ inline Entity ECS::CreateEntity() { return Entity(_CreateEntity(), this); }
 inline Entity ECS::DuplicateEntity(Entity e) { return DuplicateEntity(e.id); }
 inline void ECS::DestroyEntity(Entity e) { DestroyEntity(e.id); }
 
-inline ECS::EntityIterator ECS::begin() { return EntityIterator(0, this); }
-inline ECS::EntityIterator ECS::end() { return EntityIterator(firstFreeEntity, this); }
-
-template <class C> inline ECS::ComponentArrayT<C>::~ComponentArrayT() {
-  for (auto c : components) {
-    delete c;
-  }
+inline ECS::EntityIterator ECS::begin() {
+  return EntityIterator(uint32_t(aliveEntities.FindNext(0, firstFreeEntity)), this);
 }
+inline ECS::EntityIterator ECS::end() { return EntityIterator(firstFreeEntity, this); }
 
 template <class C> inline C *ECS::ComponentArrayT<C>::GetComponent(EntityId e) {
-  return components[entityComponentIndexMap[e]];
+  return &components[entityComponentIndexMap[IndexOf(e)]];
 }
 
 template <class C> inline C *ECS::ComponentArrayT<C>::AddComponent(EntityId e) {
-  entityComponentIndexMap[e] = static_cast<ComponentIndex>(components.size());
-  C *newComponent = new C(Entity(e, parent));
-  components.push_back(newComponent);
-  return components.back();
+  entityComponentIndexMap.Acquire(IndexOf(e)) = static_cast<ComponentIndex>(components.size());
+  entities.Set(IndexOf(e));
+  versions.push_back(version = parent->version);
+  return &components.emplace_back(Entity(e, parent));
 }
 
 template <class C> inline void ECS::ComponentArrayT<C>::RemoveComponent(EntityId e) {
-  C *component = components[entityComponentIndexMap[e]];
-  delete component;
-  components[entityComponentIndexMap[e]] = components.back();
-  entityComponentIndexMap[components.back()->entity.id] = entityComponentIndexMap[e];
+  ComponentIndex index = entityComponentIndexMap[IndexOf(e)];
+  if (index != components.size() - 1) {
+    components[index] = std::move(components.back());
+    versions[index] = versions.back();
+    entityComponentIndexMap[IndexOf(components[index].entity.id)] = index;
+  }
   components.pop_back();
+  versions.pop_back();
+  entityComponentIndexMap.Release(IndexOf(e));
+  entities.Clear(IndexOf(e));
+}
+
+// Copy constructing the pool avoids the virtual CopyFrom per component. Entity handles inside the copies still refer
+// to the source ECS; they are moved over by Entity::Rebind and the optional RebindEntities(from, to) of C.
+template <class C> ECS::ComponentArray *ECS::ComponentArrayT<C>::CloneForOtherECS(ECS *otherECS) const {
+  if constexpr (std::is_copy_constructible_v<C>) {
+    auto clone = new ComponentArrayT<C>(*this);
+    clone->parent = otherECS;
+    for (C &component : clone->components) {
+      component.entity.Rebind(parent, otherECS);
+      if constexpr (requires { component.RebindEntities(parent, otherECS); }) {
+        component.RebindEntities(parent, otherECS);
+      }
+    }
+    return clone;
+  } else {
+    return nullptr;
+  }
+}
+
+// Components are written in pool order with their entity handle and version, and restored in the same order. The
+// payload is up to C (see SnapshotWriter for what can be written).
+template <class C> bool ECS::ComponentArrayT<C>::Snapshot(SnapshotWriter &writer) const {
+  if constexpr (requires(C const &component, SnapshotWriter &w) { component.Serialize(w); }) {
+    writer.Write(uint32_t(components.size()), version);
+    for (size_t i = 0; i < components.size(); i++) {
+      writer.Write(components[i].entity.id, versions[i]);
+      components[i].Serialize(writer);
+    }
+    return true;
+  } else {
+    return false;
+  }
+}
+
+template <class C> bool ECS::ComponentArrayT<C>::Restore(SnapshotReader &reader) {
+  if constexpr (requires(C &component, SnapshotReader &r) { component.Deserialize(r); }) {
+    uint32_t count = 0, poolVersion = 0;
+    reader.Read(count, poolVersion);
+    if (reader.Failed() || count > parent->firstFreeEntity) {
+      return false;
+    }
+    components.reserve(count);
+    versions.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+      EntityId e = EntityId(-1);
+      uint32_t componentVersion = 0;
+      reader.Read(e, componentVersion);
+      // The entity flags are restored before the pools, so every component has to be announced there exactly once
+      if (reader.Failed() || !parent->HasComponent(e, ComponentID<C>::value) || entities.Test(IndexOf(e))) {
+        return false;
+      }
+      C *component = AddComponent(e);
+      versions.back() = componentVersion;
+      component->Deserialize(reader);
+    }
+    version = poolVersion;
+    return !reader.Failed();
+  } else {
+    return false;
+  }
+}
+
+template <class C>
+inline void ECS::ComponentArrayT<C>::CopyComponent(EntityId e, ComponentArray const *source, EntityId sourceEntity) {
+  C const *sourceComponent = static_cast<ComponentArrayT<C> const *>(source)->GetComponent(sourceEntity);
+  if constexpr (requires(C *component) { component->CopyFrom(*sourceComponent); }) {
+    GetComponent(e)->CopyFrom(*sourceComponent);
+  } else {
+    GetComponent(e)->CopyFrom(static_cast<Component const *>(sourceComponent));
+  }
+  MarkChanged(e);
 }
 
 template <class C> inline void ECS::RegisterComponent() {
+  std::lock_guard lock(registrationMutex);
   if (ComponentID<C>::value == componentID(-1)) {
-    ComponentID<C>::value = nextComponentID++;
+    ComponentID<C>::value = NextComponentID();
+    if constexpr (TagComponent<C>) {
+      poolFactories[ComponentID<C>::value] = [](ECS *ecs) -> ComponentArray * {
+        return new TagArray(ecs, ComponentID<C>::value);
+      };
+    } else {
+      poolFactories[ComponentID<C>::value] = [](ECS *ecs) -> ComponentArray * { return new ComponentArrayT<C>(ecs); };
+    }
   }
 }
 
+// The typed accessors go straight to the pool of C, which is final, so neither RTTI nor virtual calls are involved
 template <class C> inline C *ECS::AddComponent(EntityId e) {
-  if (!componentArrays[ComponentID<C>::value]) {
-    componentArrays[ComponentID<C>::value] = new ComponentArrayT<C>(this);
+  if (!CanAddComponent(e, ComponentID<C>::value)) {
+    return nullptr;
+  }
+  aliveAndComponentFlags[IndexOf(e)].Set(ComponentID<C>::value);
+  C *component = GetOrCreateComponentArray<C>()->AddComponent(e);
+  UpdateQueries(e);
+  return component;
+}
+
+template <class... Cs> inline void ECS::AddComponents(std::span<EntityId const> entities) {
+  (GetOrCreateComponentArray<Cs>()->Reserve(entities.size()), ...);
+  for (EntityId e : entities) {
+    // Checked in every build like AddComponent, as a stale handle or duplicate would get a second pool entry
+    if (!(CanAddComponent(e, ComponentID<Cs>::value) && ...)) {
+      continue;
+    }
+    // Constructors may look up the components attached before their own, so each flag is set right before its component
+    ((aliveAndComponentFlags[IndexOf(e)].Set(ComponentID<Cs>::value), GetComponentArray<Cs>()->AddComponent(e)), ...);
+    UpdateQueries(e);
   }
-  return dynamic_cast<C *>(AddComponent(e, ComponentID<C>::value));
 }
 
 template <class C> inline C *ECS::GetComponent(EntityId e) const {
-  return dynamic_cast<C *>(GetComponent(e, ComponentID<C>::value));
+#ifndef NDEBUG
+  if (!CanAccessComponent(e, ComponentID<C>::value)) {
+    return nullptr;
+  }
+#endif
+  return GetComponentArray<C>()->GetComponent(e);
 }
 
+inline bool ECS::HasComponent(EntityId e, ComponentIndex componentIndex) const {
+  uint32_t slot = SlotOf(e);
+  return (handles[slot] == e) & aliveAndComponentFlags[slot].Test(componentIndex);
+}
+
+// Types that were never registered have no bit in the masks
 template <class C> inline bool ECS::HasComponent(EntityId e) const {
-  if (!componentArrays[ComponentID<C>::value]) {
-    return false;
+  return ComponentID<C>::value != componentID(-1) && HasComponent(e, ComponentID<C>::value);
+}
+
+template <class C> inline void ECS::MarkChanged(EntityId e) {
+#ifndef NDEBUG
+  if (!CanAccessComponent(e, ComponentID<C>::value)) {
+    return;
   }
-  return HasComponent(e, ComponentID<C>::value);
+#endif
+  GetComponentArray<C>()->MarkChanged(e);
 }
 
-template <class C> inline void ECS::RemoveComponent(EntityId e) { RemoveComponent(e, ComponentID<C>::value); }
+template <class C> inline C *ECS::ModifyComponent(EntityId e) {
+  C *component = GetComponent<C>(e);
+  MarkChanged<C>(e);
+  return component;
+}
 
-template <class C> inline uint64_t get_flag() { return COMPONENT_FLAG(C); }
+template <class C> inline void ECS::RemoveComponent(EntityId e) {
+  if (!CanAccessComponent(e, ComponentID<C>::value)) {
+    return;
+  }
+  GetComponentArray<C>()->OnRemove(e);
+  GetComponentArray<C>()->RemoveComponent(e);
+  aliveAndComponentFlags[IndexOf(e)].Clear(ComponentID<C>::value);
+  UpdateQueries(e);
+}
+
+template <TagComponent T> inline void ECS::AddTag(EntityId e) {
+  static_assert(!std::is_same_v<T, ActiveInHierarchy>, "ActiveInHierarchy follows SetActive and the hierarchy.");
+  if (!componentArrays[ComponentID<T>::value]) {
+    componentArrays[ComponentID<T>::value] = new TagArray(this, ComponentID<T>::value);
+  }
+  AddComponent(e, ComponentID<T>::value);
+}
 
-template <class... Cs> inline std::vector<std::tuple<Cs *...>> ECS::FilterEntities(bool onlyActive) {
+template <TagComponent T> inline void ECS::RemoveTag(EntityId e) {
+  static_assert(!std::is_same_v<T, ActiveInHierarchy>, "ActiveInHierarchy follows SetActive and the hierarchy.");
+  if (!CanAccessComponent(e, ComponentID<T>::value)) {
+    return;
+  }
+  componentArrays[ComponentID<T>::value]->RemoveComponent(e);
+  aliveAndComponentFlags[IndexOf(e)].Clear(ComponentID<T>::value);
+  UpdateQueries(e);
+}
+
+template <class C> inline ComponentMask get_flag() { return COMPONENT_FLAG(C); }
+template <class... Ts> inline ComponentMask get_flags(With<Ts...>) { return (get_flag<Ts>() | ... | ComponentMask()); }
+
+template <typename Fn> inline void ECS::ForEachMatchingIndex(ComponentMask const &filterMask, Fn const &fn) const {
+  std::array<Util::Bitmap const *, ComponentMask::BIT_COUNT> bitmaps;
+  size_t bitmapCount = 0;
+  bool missingPool = false;
+  filterMask.ForEachBit([&](size_t bit) {
+    if (bit == ALIVE_BIT) {
+      bitmaps[bitmapCount++] = &aliveEntities;
+    } else if (bit == ACTIVE_BIT) {
+      bitmaps[bitmapCount++] = &activeEntities;
+    } else if (bit == ACTIVE_IN_HIERARCHY_BIT) {
+      bitmaps[bitmapCount++] = &activeInHierarchyEntities;
+    } else if (componentArrays[bit]) {
+      bitmaps[bitmapCount++] = &componentArrays[bit]->Entities();
+    } else {
+      missingPool = true;
+    }
+  });
+  if (!missingPool) {
+    Util::Bitmap::ForEachSetInAll(std::span(bitmaps.data(), bitmapCount), fn);
+  }
+}
+
+// Matches are ordered by entity index
+template <class... Cs, class... Ts>
+inline std::vector<std::tuple<Cs *...>> ECS::FilterEntities(With<Ts...> with, bool onlyActive) {
   std::vector<std::tuple<Cs *...>> result;
-  uint64_t filterMask = ALIVE_FLAG | (get_flag<Cs>() | ...);
+  ComponentMask filterMask =
+      ALIVE_FLAG | (onlyActive ? ACTIVE_FLAG : ComponentMask()) | (get_flag<Cs>() | ...) | get_flags(with);
+  if (!(GetComponentArray<Cs>() && ...)) {
+    return result;
+  }
+  result.reserve(std::min({GetComponentArray<Cs>()->Size()...}));
+
+  ForEachMatchingIndex(filterMask, [&](size_t index) {
+    result.push_back(std::make_tuple(GetComponentArray<Cs>()->GetComponent(handles[index])...));
+  });
+
+  return result;
+}
 
-  for (int e = 0; e < firstFreeEntity; e++) {
-    if ((aliveAndComponentFlags[e] & filterMask) == filterMask &&
-        (!onlyActive || aliveAndComponentFlags[e] & ACTIVE_FLAG)) {
-      result.push_back(std::make_tuple(GetComponent<Cs>(e)...));
+template <class... Ts> inline std::vector<Entity> ECS::EntitiesWith(bool onlyActive) {
+  std::vector<Entity> result;
+  ComponentMask filterMask = ALIVE_FLAG | (onlyActive ? ACTIVE_FLAG : ComponentMask()) | get_flags(With<Ts...>());
+  ForEachMatchingIndex(filterMask, [&](size_t index) { result.push_back(Entity(handles[index], this)); });
+  return result;
+}
+
+template <class C, class... Cs>
+inline std::vector<std::tuple<C *, Cs *...>> ECS::Changed(uint32_t since, bool onlyActive) {
+  std::vector<std::tuple<C *, Cs *...>> result;
+  ComponentMask filterMask = ALIVE_FLAG | (onlyActive ? ACTIVE_FLAG : ComponentMask()) | get_flag<C>() |
+                             (get_flag<Cs>() | ... | ComponentMask());
+
+  auto array = GetComponentArray<C>();
+  if (!array || array->Version() <= since) {
+    return result;
+  }
+
+  for (size_t i = 0; i < array->Size(); i++) {
+    if (array->Version(i) > since) {
+      EntityId e = (*array)[i].entity.id;
+      if (aliveAndComponentFlags[IndexOf(e)].Contains(filterMask)) {
+        result.push_back(std::make_tuple(&(*array)[i], GetComponentArray<Cs>()->GetComponent(e)...));
+      }
     }
   }
 
   return result;
 }
 
-inline void ECS::SetActive(EntityId e, bool active) {
-  aliveAndComponentFlags[e] =
-      active ? aliveAndComponentFlags[e] | ACTIVE_FLAG : aliveAndComponentFlags[e] & ~ACTIVE_FLAG;
+template <class... Cs, class... Ts> inline ECS::QueryView<Cs...> ECS::Query(With<Ts...> with, bool onlyActive) {
+  ComponentMask filterMask =
+      ALIVE_FLAG | (onlyActive ? ACTIVE_FLAG : ComponentMask()) | (get_flag<Cs>() | ...) | get_flags(with);
+  return QueryView<Cs...>(this, &GetCachedQuery(filterMask).matches);
+}
+
+template <class... Cs, typename Fn, class... Ts>
+inline void ECS::ParallelForEach(Fn const &fn, With<Ts...> with, size_t grainSize, bool onlyActive) {
+  ComponentMask filterMask =
+      ALIVE_FLAG | (onlyActive ? ACTIVE_FLAG : ComponentMask()) | (get_flag<Cs>() | ...) | get_flags(with);
+  std::vector<EntityId> const &matches = GetCachedQuery(filterMask).matches;
+  if (grainSize == 0) {
+    grainSize = std::max<size_t>(1, PARALLEL_CHUNK_BYTES / (sizeof(Cs) + ...));
+  }
+
+  auto arrays = std::make_tuple(GetComponentArray<Cs>()...);
+  auto runChunk = [&](size_t chunk) {
+    size_t chunkEnd = std::min(matches.size(), (chunk + 1) * grainSize);
+    for (size_t i = chunk * grainSize; i < chunkEnd; i++) {
+      EntityId e = matches[i];
+      std::apply(
+          [&](auto *...array) {
+            if constexpr (std::is_invocable_v<Fn const &, size_t, Cs *...>) {
+              fn(i, array->GetComponent(e)...);
+            } else {
+              fn(array->GetComponent(e)...);
+            }
+          },
+          arrays);
+    }
+  };
+
+  Util::ThreadPool::Shared().ParallelFor((matches.size() + grainSize - 1) / grainSize, runChunk);
 }
 
-inline bool ECS::IsActive(EntityId e) const { return aliveAndComponentFlags[e] & ACTIVE_FLAG; }
+template <class R, typename... Args> inline R *ECS::EmplaceResource(Args &&...args) {
+  uint32_t index = ResourceIndex<R>();
+  if (index >= resources.size()) {
+    resources.resize(index + 1);
+  }
+  auto resource = std::make_shared<R>(std::forward<Args>(args)...);
+  resources[index] = resource;
+  return resource.get();
+}
+
+template <class R> inline R *ECS::GetResource() const {
+  uint32_t index = ResourceIndex<R>();
+  return index < resources.size() ? static_cast<R *>(resources[index].get()) : nullptr;
+}
 
-inline bool ECS::IsAlive(EntityId e) const { return e != EntityId(-1) && (aliveAndComponentFlags[e] & ALIVE_FLAG); }
+template <class R> inline void ECS::RemoveResource() {
+  uint32_t index = ResourceIndex<R>();
+  if (index < resources.size()) {
+    resources[index].reset();
+  }
+}
+
+inline bool ECS::IsActive(EntityId e) const {
+  uint32_t slot = SlotOf(e);
+  return (handles[slot] == e) & aliveAndComponentFlags[slot].Test(ACTIVE_BIT);
+}
+
+inline bool ECS::IsActiveInHierarchy(EntityId e) const {
+  uint32_t slot = SlotOf(e);
+  return (handles[slot] == e) & aliveAndComponentFlags[slot].Test(ACTIVE_IN_HIERARCHY_BIT);
+}
+
+inline bool ECS::IsAlive(EntityId e) const {
+  uint32_t slot = SlotOf(e);
+  return (handles[slot] == e) & aliveAndComponentFlags[slot].Test(ALIVE_BIT);
+}
 
 } // namespace Engine::Core
@@ -0,0 +1,95 @@
+#include "ECSCommandBuffer.h"
+
+#include "Debug/Logging.h"
+
+#include <algorithm>
+
+namespace Engine::Core {
+
+void ECSCommandBuffer::Clear() {
+  creations.clear();
+  componentCommands.clear();
+  destructions.clear();
+}
+
+void ECSCommandBuffer::Append(ECSCommandBuffer &&other) {
+  uint32_t offset = uint32_t(creations.size());
+  auto shift = [offset](Target target) {
+    if (target.deferred != NOT_DEFERRED) {
+      target.deferred += offset;
+    }
+    return target;
+  };
+
+  creations.insert(creations.end(), other.creations.begin(), other.creations.end());
+  for (auto &command : other.componentCommands) {
+    command.target = shift(command.target);
+    componentCommands.push_back(std::move(command));
+  }
+  for (auto const &target : other.destructions) {
+    destructions.push_back(shift(target));
+  }
+  other.Clear();
+}
+
+void ECSCommandBuffer::RunGrouped(ECS *ecs, std::vector<ComponentCommand> &commands,
+                                  std::vector<Entity> const &created) {
+  // Stable, so that commands on the same component of an entity are applied in the order they were recorded
+  std::stable_sort(commands.begin(), commands.end(),
+                   [](ComponentCommand const &a, ComponentCommand const &b) { return a.component < b.component; });
+
+  for (size_t groupStart = 0; groupStart < commands.size();) {
+    size_t groupEnd = groupStart;
+    while (groupEnd < commands.size() && commands[groupEnd].component == commands[groupStart].component) {
+      groupEnd++;
+    }
+    // Only component additions reserve (tags have no storage), and removals of the type may come first
+    auto group = std::span(commands).subspan(groupStart, groupEnd - groupStart);
+    auto reserves = [](ComponentCommand const &command) { return command.reserve != nullptr; };
+    if (auto addition = std::ranges::find_if(group, reserves); addition != group.end()) {
+      addition->reserve(ecs, std::ranges::count_if(group, reserves));
+    }
+    for (size_t i = groupStart; i < groupEnd; i++) {
+      Target const &target = commands[i].target;
+      EntityId e = target.deferred == NOT_DEFERRED ? target.entity : created[target.deferred].id;
+      // Entities may have been destroyed since the command was recorded
+      if (ecs->IsAlive(e)) {
+        commands[i].apply(ecs, e, commands[i].initialize);
+      }
+    }
+    groupStart = groupEnd;
+  }
+}
+
+std::vector<Entity> ECSCommandBuffer::Playback(ECS *ecs) {
+  uint32_t emptyCreations =
+      uint32_t(std::count_if(creations.begin(), creations.end(), [](Creation const &c) { return !c.copy; }));
+  std::vector<EntityId> emptyEntities = ecs->CreateEntities(emptyCreations);
+
+  std::vector<Entity> created{};
+  created.reserve(creations.size());
+  auto nextEmpty = emptyEntities.begin();
+  for (auto const &creation : creations) {
+    if (!creation.copy) {
+      created.push_back(Entity(*nextEmpty++, ecs));
+    } else if (creation.source.IsAlive()) {
+      created.push_back(creation.source.CopyToOtherECS(ecs));
+    } else {
+      ENGINE_WARNING("Tried to instantiate dead entity!")
+      created.push_back(Entity());
+    }
+  }
+
+  RunGrouped(ecs, componentCommands, created);
+  for (auto const &target : destructions) {
+    EntityId e = target.deferred == NOT_DEFERRED ? target.entity : created[target.deferred].id;
+    if (ecs->IsAlive(e)) {
+      ecs->DestroyEntity(e);
+    }
+  }
+
+  Clear();
+  return created;
+}
+
+} // namespace Engine::Core
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Core/ECS.h"
+
+#include <functional>
+
+#define NOT_DEFERRED uint32_t(-1)
+
+namespace Engine::Core {
+
+// Entity that only gets created once the command buffer that recorded it is played back
+struct DeferredEntity {
+  uint32_t index;
+};
+
+// Records structural changes so that they can be made while iterating an ECS or from other threads, and applies them
+// at the next sync point (see ECS::Commands and ECS::PlaybackCommands). Playback first creates all entities, then
+// adds and removes components and finally destroys. Component operations are grouped by type, so every pool is grown
+// only once, and keep the order they were recorded in within their type (e.g. removing and re-adding a component).
+class ECSCommandBuffer {
+  using Initializer = std::function<void(Component *)>;
+
+  struct Target {
+    EntityId entity;
+    uint32_t deferred; // Index into creations, NOT_DEFERRED for existing entities
+  };
+
+  struct Creation {
+    bool copy;
+    Entity source;
+  };
+
+  struct ComponentCommand {
+    componentID component;
+    Target target;
+    void (*apply)(ECS *ecs, EntityId e, Initializer const &initialize);
+    void (*reserve)(ECS *ecs, size_t count); // nullptr for removals and tags
+    Initializer initialize;
+  };
+
+  std::vector<Creation> creations;
+  std::vector<ComponentCommand> componentCommands; // Additions and removals, in recording order
+  std::vector<Target> destructions;
+
+  template <class C> static void Attach(ECS *ecs, EntityId e, Initializer const &initialize);
+  template <class C> static void Detach(ECS *ecs, EntityId e, Initializer const &);
+  template <class T> static void AttachTag(ECS *ecs, EntityId e, Initializer const &);
+  template <class T> static void DetachTag(ECS *ecs, EntityId e, Initializer const &);
+  template <class C> static void Reserve(ECS *ecs, size_t count) {
+    ecs->GetOrCreateComponentArray<C>()->Reserve(count);
+  }
+
+  inline static Target TargetOf(Entity const &e) { return Target{e.id, NOT_DEFERRED}; }
+  inline static Target TargetOf(DeferredEntity e) { return Target{EntityId(-1), e.index}; }
+
+  void RunGrouped(ECS *ecs, std::vector<ComponentCommand> &commands, std::vector<Entity> const &created);
+
+public:
+  inline DeferredEntity CreateEntity() {
+    creations.push_back(Creation{false, Entity()});
+    return DeferredEntity{uint32_t(creations.size() - 1)};
+  }
+  // Copies source (with its children) into the ECS the buffer is played back on
+  inline DeferredEntity InstantiateEntity(Entity const &source) {
+    creations.push_back(Creation{true, source});
+    return DeferredEntity{uint32_t(creations.size() - 1)};
+  }
+
+  template <typename E> inline void DestroyEntity(E const &e) { destructions.push_back(TargetOf(e)); }
+
+  // initialize is called on the component right after it has been attached
+  template <class C, typename E> inline void AddComponent(E const &e, std::function<void(C *)> initialize = {}) {
+    Initializer typedInitialize{};
+    if (initialize) {
+      typedInitialize = [initialize](Component *component) { initialize(static_cast<C *>(component)); };
+    }
+    componentCommands.push_back(ComponentCommand{ComponentID<C>::value, TargetOf(e), &Attach<C>, &Reserve<C>,
+                                                 std::move(typedInitialize)});
+  }
+  template <class C, typename E> inline void RemoveComponent(E const &e) {
+    componentCommands.push_back(ComponentCommand{ComponentID<C>::value, TargetOf(e), &Detach<C>, nullptr, {}});
+  }
+
+  template <TagComponent T, typename E> inline void AddTag(E const &e) {
+    componentCommands.push_back(ComponentCommand{ComponentID<T>::value, TargetOf(e), &AttachTag<T>, nullptr, {}});
+  }
+  template <TagComponent T, typename E> inline void RemoveTag(E const &e) {
+    componentCommands.push_back(ComponentCommand{ComponentID<T>::value, TargetOf(e), &DetachTag<T>, nullptr, {}});
+  }
+
+  inline bool Empty() const {
+    return creations.empty() && componentCommands.empty() && destructions.empty();
+  }
+  void Clear();
+  // Moves all commands of other behind the ones of this buffer
+  void Append(ECSCommandBuffer &&other);
+  // Returns the created entities, indexed by their DeferredEntity
+  std::vector<Entity> Playback(ECS *ecs);
+};
+
+template <class C> void ECSCommandBuffer::Attach(ECS *ecs, EntityId e, Initializer const &initialize) {
+  // Constructors of components attached before may have attached this one already
+  C *component = ecs->HasComponent<C>(e) ? ecs->ModifyComponent<C>(e) : ecs->AddComponent<C>(e);
+  if (component && initialize) {
+    initialize(component);
+  }
+}
+
+template <class C> void ECSCommandBuffer::Detach(ECS *ecs, EntityId e, Initializer const &) {
+  if (ecs->HasComponent<C>(e)) {
+    ecs->RemoveComponent<C>(e);
+  }
+}
+
+template <class T> void ECSCommandBuffer::AttachTag(ECS *ecs, EntityId e, Initializer const &) {
+  if (!ecs->HasTag<T>(e)) {
+    ecs->AddTag<T>(e);
+  }
+}
+
+template <class T> void ECSCommandBuffer::DetachTag(ECS *ecs, EntityId e, Initializer const &) {
+  if (ecs->HasTag<T>(e)) {
+    ecs->RemoveTag<T>(e);
+  }
+}
+
+} // namespace Engine::Core
@@ -3,74 +3,104 @@
 #include "Core/ECS.h"
 #include "Debug/Logging.h"
 
-namespace Engine {
-class SceneCache;
-}
-
 namespace Engine::Core {
 
 class HierarchyComponent;
 
 class HierarchyListener {
 protected:
-  HierarchyComponent *hierarchy;
-  friend class SceneCache;
+  Entity hierarchyOwner;
 
 public:
-  HierarchyListener(HierarchyComponent *hierarchy) : hierarchy(hierarchy) {};
-  virtual void OnHierarchyChange() = 0;
+  HierarchyListener(Entity owner) : hierarchyOwner(owner) {};
+  inline HierarchyComponent *Hierarchy() const;
+  // Called by HierarchyComponent::SetParent right before the parent changes, so the old one can still be read
+  virtual void OnHierarchyChange(Entity const &newParent) = 0;
+  inline void RebindEntities(ECS const *from, ECS *to) { hierarchyOwner.Rebind(from, to); }
 };
 
 template <typename T> class HierarchicalComponent : public ComponentT<T>, public HierarchyListener {
+  // Listeners are resolved through their entity, as components can be relocated within their pool
+  static HierarchyListener *ResolveListener(Entity const &entity) {
+    return entity.HasComponent<T>() ? entity.GetComponent<T>() : nullptr;
+  }
+
 public:
   HierarchicalComponent(Entity entity);
-  virtual void OnHierarchyChange() override = 0;
+  virtual void OnHierarchyChange(Entity const &newParent) override = 0;
 };
 
 class HierarchyComponent : public ComponentT<HierarchyComponent> {
-  std::vector<HierarchyListener *> hierarchyChangeListeners;
+public:
+  using ListenerResolver = HierarchyListener *(*)(Entity const &);
+
+private:
+  std::vector<ListenerResolver> hierarchyChangeListeners;
 
 public:
-  HierarchyComponent *parent;
-  std::vector<HierarchyComponent *> children;
+  Entity parent;
+  std::vector<Entity> children;
 
-  HierarchyComponent(Entity entity) : ComponentT<HierarchyComponent>(entity), parent(nullptr), children() {}
+  HierarchyComponent(Entity entity) : ComponentT<HierarchyComponent>(entity), parent(), children() {}
+  // nullptr detaches the entity, which makes it a root
   inline void SetParent(HierarchyComponent *newParent);
-  inline void RegisterListener(HierarchyListener *listener) { hierarchyChangeListeners.push_back(listener); }
+  inline void RegisterListener(ListenerResolver listener) { hierarchyChangeListeners.push_back(listener); }
   inline void CopyFrom(HierarchyComponent const &other) override;
+  // Listeners are not written, they register again when their components are restored
+  inline void Serialize(SnapshotWriter &writer) const { writer.Write(parent, children); }
+  inline void Deserialize(SnapshotReader &reader) { reader.Read(parent, children); }
+  inline void RebindEntities(ECS const *from, ECS *to) {
+    parent.Rebind(from, to);
+    for (auto &child : children) {
+      child.Rebind(from, to);
+    }
+  }
 };
 
+inline HierarchyComponent *HierarchyListener::Hierarchy() const {
+  return hierarchyOwner.GetComponent<HierarchyComponent>();
+}
+
 template <typename T>
 inline HierarchicalComponent<T>::HierarchicalComponent(Entity entity)
-    : ComponentT<T>(entity),
-      HierarchyListener(entity.HasComponent<HierarchyComponent>() ? entity.GetComponent<HierarchyComponent>()
-                                                                  : entity.AddComponent<HierarchyComponent>()) {
+    : ComponentT<T>(entity), HierarchyListener(entity) {
   if (!entity.HasComponent<HierarchyComponent>()) {
-    hierarchy = entity.AddComponent<HierarchyComponent>();
-  } else {
-    hierarchy = entity.GetComponent<HierarchyComponent>();
+    entity.AddComponent<HierarchyComponent>();
   }
-  hierarchy->RegisterListener(this);
+  Hierarchy()->RegisterListener(&HierarchicalComponent<T>::ResolveListener);
 }
 
 void HierarchyComponent::SetParent(HierarchyComponent *newParent) {
-  if (parent) {
-    parent->children.erase(std::remove(parent->children.begin(), parent->children.end(), this), parent->children.end());
+  // Listeners may modify their components, but never add any, so this component stays in place
+  Entity newParentEntity = newParent ? newParent->entity : Entity();
+  for (auto resolveListener : hierarchyChangeListeners) {
+    if (auto listener = resolveListener(entity)) {
+      listener->OnHierarchyChange(newParentEntity);
+    }
   }
 
-  parent = newParent;
-  newParent->children.push_back(this);
+  if (parent.IsAlive()) {
+    auto &siblings = parent.GetComponent<HierarchyComponent>()->children;
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), entity), siblings.end());
+  }
 
-  for (auto listener : hierarchyChangeListeners) {
-    listener->OnHierarchyChange();
+  parent = newParentEntity;
+  if (newParent) {
+    newParent->children.push_back(entity);
   }
+  entity.parentECS->NotifyParentChange(entity.id);
 }
 
 void HierarchyComponent::CopyFrom(HierarchyComponent const &other) {
-  for (auto child : other.children) {
-    auto newChild = child->entity.CopyToOtherECS(entity.parentECS).GetComponent<HierarchyComponent>();
-    newChild->parent = this;
-    children.push_back(newChild);
+  // Copying the children adds HierarchyComponents to the pool containing this component (and possibly other), which
+  // invalidates both references. Only handles are used from here on.
+  Entity self = entity;
+  std::vector<Entity> otherChildren = other.children;
+  for (auto const &child : otherChildren) {
+    auto newChild = child.CopyToOtherECS(self.parentECS);
+    newChild.GetComponent<HierarchyComponent>()->parent = self;
+    self.GetComponent<HierarchyComponent>()->children.push_back(newChild);
+    self.parentECS->NotifyParentChange(newChild.id);
   }
 }
 
@@ -7,14 +7,12 @@ namespace Engine::Core {
 
 struct Scene {
   ECS ecs;
-  SceneHierarchy sceneHierarchy;
+  SceneHierarchy &sceneHierarchy; // Resource of ecs, so that systems can reach it
   Entity mainCamera;
 
-  Scene() : ecs(), sceneHierarchy(&ecs), mainCamera() {};
+  Scene() : ecs(), sceneHierarchy(*ecs.EmplaceResource<SceneHierarchy>(&ecs)), mainCamera() {};
   inline Entity InstantiateEntity(Entity const &entity) {
-    auto instance = entity.CopyToOtherECS(&ecs);
-    sceneHierarchy.Rebuild();
-    return instance;
+    return entity.CopyToOtherECS(&ecs); // sceneHierarchy follows the new entities on its own
   }
 };
 
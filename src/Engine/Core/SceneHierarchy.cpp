@@ -2,23 +2,110 @@
 
 #include "Core/HierarchyComponent.h"
 
-Engine::Core::SceneHierarchy::TreeNode Engine::Core::SceneHierarchy::BuildNode(Entity const &e) {
-  TreeNode node;
-  node.entity = e;
+#define NOT_A_ROOT uint32_t(-1)
 
-  if (e.HasComponent<Core::HierarchyComponent>()) {
-    for (auto c : e.GetComponent<Core::HierarchyComponent>()->children) {
-      node.children.push_back(BuildNode(c->entity));
-    }
+namespace Engine::Core {
+SceneHierarchy::SceneHierarchy(ECS *ecs) : ecs(ecs), positions(), flattened(), flattenedOutdated(true), roots() {
+  ecs->AddObserver(this);
+  Rebuild();
+}
+
+SceneHierarchy::~SceneHierarchy() { ecs->RemoveObserver(this); }
+
+std::vector<Entity> const &SceneHierarchy::ChildrenOf(Entity const &e) {
+  static const std::vector<Entity> noChildren{};
+  return e.HasComponent<HierarchyComponent>() ? e.GetComponent<HierarchyComponent>()->children : noChildren;
+}
+
+bool SceneHierarchy::TreeNode::HasChildren() const { return !ChildrenOf(entity).empty(); }
+
+void SceneHierarchy::AddRoot(EntityId e) {
+  flattenedOutdated = true;
+  uint32_t index = IndexOf(e);
+  if (positions.size() <= index) {
+    positions.resize(index + 1, NOT_A_ROOT);
   }
-  return node;
+  if (positions[index] == NOT_A_ROOT) {
+    positions[index] = static_cast<uint32_t>(roots.size());
+    roots.push_back(TreeNode{Entity(e, ecs)});
+  }
+}
+
+void SceneHierarchy::RemoveRoot(EntityId e) {
+  flattenedOutdated = true;
+  uint32_t index = IndexOf(e);
+  if (index >= positions.size() || positions[index] == NOT_A_ROOT) {
+    return;
+  }
+  TreeNode last = roots.back();
+  roots[positions[index]] = last;
+  positions[IndexOf(last.entity.id)] = positions[index];
+  positions[index] = NOT_A_ROOT;
+  roots.pop_back();
 }
 
-void Engine::Core::SceneHierarchy::Rebuild() {
-  roots = std::vector<TreeNode>();
+void SceneHierarchy::Rebuild() {
+  roots.clear();
+  positions.clear();
+  flattenedOutdated = true;
   for (auto e : *ecs) {
-    if (!e.HasComponent<Core::HierarchyComponent>() || !e.GetComponent<Core::HierarchyComponent>()->parent) {
-      roots.push_back(BuildNode(e));
+    if (!e.HasComponent<HierarchyComponent>() || !e.GetComponent<HierarchyComponent>()->parent.IsAlive()) {
+      AddRoot(e.id);
     }
   }
 }
+
+SceneHierarchy::Flattened const &SceneHierarchy::Flatten() {
+  if (!flattenedOutdated) {
+    return flattened;
+  }
+  flattened.entities.clear();
+  flattened.parents.clear();
+  flattened.levels.clear();
+  for (auto const &root : roots) {
+    flattened.entities.push_back(root.entity);
+    flattened.parents.push_back(Flattened::NO_PARENT);
+  }
+
+  // Every level is appended while walking the one before
+  size_t begin = 0;
+  while (begin < flattened.entities.size()) {
+    size_t end = flattened.entities.size();
+    flattened.levels.push_back(uint32_t(begin));
+    for (size_t i = begin; i < end; i++) {
+      for (auto const &child : ChildrenOf(flattened.entities[i])) {
+        if (child.IsAlive()) {
+          flattened.entities.push_back(child);
+          flattened.parents.push_back(uint32_t(i));
+        }
+      }
+    }
+    begin = end;
+  }
+  flattened.levels.push_back(uint32_t(flattened.entities.size()));
+  flattenedOutdated = false;
+  return flattened;
+}
+
+void SceneHierarchy::OnCreate(EntityId e) { AddRoot(e); }
+
+void SceneHierarchy::OnDestroy(EntityId e) {
+  RemoveRoot(e);
+  // Children of a destroyed entity are left without a living parent
+  Entity entity(e, ecs);
+  for (auto const &child : ChildrenOf(entity)) {
+    if (child.IsAlive() && child.GetComponent<HierarchyComponent>()->parent == entity) {
+      AddRoot(child.id);
+    }
+  }
+}
+
+void SceneHierarchy::OnParentChange(EntityId e) {
+  if (ecs->GetComponent<HierarchyComponent>(e)->parent.IsAlive()) {
+    RemoveRoot(e);
+  } else {
+    AddRoot(e);
+  }
+}
+
+} // namespace Engine::Core
@@ -5,34 +5,93 @@
 #include "Util/Macros.h"
 
 namespace Engine::Core {
-class SceneHierarchy {
-  public:
+// Roots of the entity hierarchy of an ECS, i.e. entities without a living parent. The roots are kept up to date on
+// every change of the ECS (like cached queries), while children are read from the HierarchyComponents on iteration.
+class SceneHierarchy : public ECS::Observer {
+public:
   struct TreeNode;
-  private:
+
+  // The hierarchy in breadth-first order, so that the entities of one depth (a level) are contiguous and come after
+  // all of their parents. Levels can be processed one after another, the entities within a level in parallel.
+  struct Flattened {
+    static constexpr uint32_t NO_PARENT = uint32_t(-1);
+
+    std::vector<Entity> entities;
+    std::vector<uint32_t> parents; // Index into entities per entity, NO_PARENT for roots
+    std::vector<uint32_t> levels;  // Index of the first entity of every level, followed by entities.size()
+
+    inline size_t LevelCount() const { return levels.size() - 1; }
+    inline size_t LevelBegin(size_t level) const { return levels[level]; }
+    inline size_t LevelEnd(size_t level) const { return levels[level + 1]; }
+  };
+
+private:
   ECS *ecs;
-  TreeNode BuildNode(Entity const &e);
+  std::vector<uint32_t> positions; // Index into roots per entity index
+  Flattened flattened;
+  bool flattenedOutdated; // Set on any change of the roots or parents, the arrays are only rebuilt on access
+
+  void AddRoot(EntityId e);
+  void RemoveRoot(EntityId e);
 
 public:
-  SceneHierarchy(ECS *ecs) : ecs(ecs) {}
+  SceneHierarchy(ECS *ecs);
+  SceneHierarchy(SceneHierarchy const &) = delete;
+  SceneHierarchy &operator=(SceneHierarchy const &) = delete;
+  ~SceneHierarchy();
+  // Only needed if the hierarchy was changed without going through HierarchyComponent::SetParent
   void Rebuild();
+  inline bool IsRoot(Entity const &e) const;
+  // Not thread-safe, as it rebuilds the arrays after structural changes
+  Flattened const &Flatten();
 
-  struct TreeNode {
-  private:
-    std::vector<TreeNode> children;
+  void OnCreate(EntityId e) override;
+  void OnDestroy(EntityId e) override;
+  void OnParentChange(EntityId e) override;
+  inline void OnReset() override { Rebuild(); }
 
-  public:
+  class ChildIterator;
+
+  // View of an entity, copying it doesn't copy its children
+  struct TreeNode {
     Entity entity;
-    inline bool HasChildren() const { return !children.empty(); }
-    inline std::vector<TreeNode>::const_iterator begin() const { return children.begin(); }
-    inline std::vector<TreeNode>::const_iterator end() const { return children.end(); }
+    bool HasChildren() const;
+    inline ChildIterator begin() const;
+    inline ChildIterator end() const;
+  };
+
+  class ChildIterator {
+    std::vector<Entity>::const_iterator child;
 
-    friend TreeNode SceneHierarchy::BuildNode(Entity const &e);
+  public:
+    ChildIterator(std::vector<Entity>::const_iterator child) : child(child) {}
+    inline TreeNode operator*() const { return TreeNode{*child}; }
+    inline ChildIterator &operator++() {
+      ++child;
+      return *this;
+    }
+    inline bool operator!=(ChildIterator const &other) const { return child != other.child; }
   };
 
-  std::vector<TreeNode> roots;
+  std::vector<TreeNode> roots; // Unordered, removing a root moves the last one into its place
 
   inline std::vector<TreeNode>::const_iterator begin() const { return roots.begin(); }
   inline std::vector<TreeNode>::const_iterator end() const { return roots.end(); }
+
+private:
+  static std::vector<Entity> const &ChildrenOf(Entity const &e);
 }; // class SceneHierarchy
 
+inline bool SceneHierarchy::IsRoot(Entity const &e) const {
+  uint32_t index = IndexOf(e.id);
+  return index < positions.size() && positions[index] != uint32_t(-1) && roots[positions[index]].entity == e;
+}
+
+inline SceneHierarchy::ChildIterator SceneHierarchy::TreeNode::begin() const {
+  return ChildIterator(ChildrenOf(entity).begin());
+}
+inline SceneHierarchy::ChildIterator SceneHierarchy::TreeNode::end() const {
+  return ChildIterator(ChildrenOf(entity).end());
+}
+
 } // namespace Engine::Core
@@ -0,0 +1,36 @@
+#include "SceneRunner.h"
+
+#include "Debug/Logging.h"
+#include "Debug/Profiling.h"
+#include "Util/Macros.h"
+
+#include <algorithm>
+
+namespace Engine::Core {
+
+void SceneRunner::AddScene(Scene *scene) {
+  if (std::ranges::any_of(scenes, [scene](RunningScene const &running) { return running.scene == scene; })) {
+    ENGINE_WARNING("Tried to add a scene to the runner twice!") return;
+  }
+  RunningScene &running = scenes.emplace_back(RunningScene{scene, Clock()});
+  running.clock.Start();
+}
+
+void SceneRunner::RemoveScene(Scene *scene) {
+  std::erase_if(scenes, [scene](RunningScene const &running) { return running.scene == scene; });
+}
+
+void SceneRunner::Update() {
+  PROFILE_FUNCTION()
+
+  // Systems may have been added since the last update, the scheduler must not change once the scenes run
+  systems->Prepare();
+  pool->ParallelFor(scenes.size(), [this](size_t i) {
+    RunningScene &running = scenes[i];
+    running.clock.Update();
+    running.scene->ecs.AdvanceVersion();
+    systems->RunPrepared(&running.scene->ecs, running.clock, *pool);
+  });
+}
+
+} // namespace Engine::Core
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Core/Scene.h"
+#include "Core/SystemScheduler.h"
+#include "Core/Time.h"
+#include "Util/ThreadPool.h"
+
+#include <vector>
+
+namespace Engine::Core {
+
+// Updates independent scenes (e.g. one per session) concurrently on a thread pool. Each scene is only ever touched by
+// one task, systems inside it may still spread over the pool. Scenes share nothing but the registered component types,
+// the SystemScheduler, which is prepared before and only read while they run, and whatever the systems capture, which
+// has to be thread-safe or read-only (e.g. the AssetManager).
+class SceneRunner {
+  struct RunningScene {
+    Scene *scene;
+    Clock clock;
+  };
+
+  SystemScheduler *systems;
+  Util::ThreadPool *pool;
+  std::vector<RunningScene> scenes;
+
+public:
+  // Sync functions of systems may only touch the ECS they are called with
+  SceneRunner(SystemScheduler *systems, Util::ThreadPool &pool = Util::ThreadPool::Shared())
+      : systems(systems), pool(&pool), scenes() {}
+
+  void AddScene(Scene *scene); // Starts the clock of the scene
+  void RemoveScene(Scene *scene);
+  inline size_t SceneCount() const { return scenes.size(); }
+
+  // Runs the systems once on every scene and returns when all scenes are done
+  void Update();
+};
+
+} // namespace Engine::Core
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core/ECS.h"
+#include "Core/ECSCommandBuffer.h"
 #include "Core/Time.h"
 
 namespace Engine::Core {
@@ -27,6 +28,16 @@ struct ScriptComponent : public ComponentT<ScriptComponent> {
 
 public:
   ScriptComponent(Entity entity) : ComponentT<ScriptComponent>(entity) {};
+  // Moves happen when the component is relocated within its pool; the scripts have to stay owned exactly once
+  ScriptComponent(ScriptComponent &&other) noexcept
+      : ComponentT<ScriptComponent>(other.entity), scripts(std::move(other.scripts)) {
+    other.scripts.clear();
+  }
+  ScriptComponent &operator=(ScriptComponent &&other) noexcept {
+    entity = other.entity;
+    std::swap(scripts, other.scripts);
+    return *this;
+  }
   template <class T, class... T_Args> inline T *InstantiateScript(T_Args... args) {
     T *script = new T(entity, args...);
     script->OnCreate();
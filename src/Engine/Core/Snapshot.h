@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstring>
+#include <inttypes.h>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Engine::Core {
+
+class ECS;
+class Entity;
+
+// Values without pointers to other objects are copied byte by byte. Entity is handled separately, as its handle has to
+// be moved over to the ECS a snapshot is restored into.
+template <typename T>
+concept RawSnapshot = !std::is_same_v<T, Entity> && !std::is_pointer_v<T> && std::is_trivially_copyable_v<T>;
+
+// Appends values to a fixed buffer. Writing continues to count bytes once the buffer is full, so that Size() is always
+// what the whole snapshot needs. Entities of other ECSs can't be written and fail the writer.
+class SnapshotWriter {
+  std::span<std::byte> buffer;
+  size_t size;
+  bool failed;
+  ECS const *ecs;
+
+public:
+  SnapshotWriter(std::span<std::byte> buffer, ECS const *ecs) : buffer(buffer), size(0), failed(false), ecs(ecs) {}
+
+  template <RawSnapshot T> inline void WriteRaw(T const *values, size_t count) {
+    if (size + count * sizeof(T) <= buffer.size() && count > 0) {
+      std::memcpy(buffer.data() + size, values, count * sizeof(T));
+    }
+    size += count * sizeof(T);
+  }
+
+  template <RawSnapshot T> inline void Write(T const &value) { WriteRaw(&value, 1); }
+  // Pointers are written as addresses, so they can only be restored in the process that took the snapshot
+  template <typename T> inline void Write(T *const &pointer) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+    WriteRaw(&address, 1);
+  }
+  void Write(Entity const &entity);
+  inline void Write(std::string const &string) {
+    Write(uint32_t(string.size()));
+    WriteRaw(string.data(), string.size());
+  }
+  template <typename T> inline void Write(std::vector<T> const &values) {
+    Write(uint32_t(values.size()));
+    if constexpr (RawSnapshot<T>) {
+      WriteRaw(values.data(), values.size());
+    } else {
+      for (auto const &value : values) {
+        Write(value);
+      }
+    }
+  }
+  template <typename... Ts> inline void Write(Ts const &...values) requires(sizeof...(Ts) > 1) { (Write(values), ...); }
+
+  inline size_t Size() const { return size; }
+  inline bool Complete() const { return size <= buffer.size(); }
+  inline bool Failed() const { return failed; }
+};
+
+// Reads values back in the order they were written. Reading past the end, or an entity that isn't in the snapshot or in
+// no ECS, fails the reader instead of touching memory outside the snapshot; the values read from then on are left
+// untouched.
+class SnapshotReader {
+  std::span<std::byte const> snapshot;
+  size_t offset;
+  bool failed;
+  ECS *ecs;
+
+public:
+  SnapshotReader(std::span<std::byte const> snapshot, ECS *ecs)
+      : snapshot(snapshot), offset(0), failed(false), ecs(ecs) {}
+
+  template <RawSnapshot T> inline void ReadRaw(T *values, size_t count) {
+    if (failed || offset + count * sizeof(T) > snapshot.size()) {
+      failed = true;
+      return;
+    }
+    if (count > 0) {
+      std::memcpy(values, snapshot.data() + offset, count * sizeof(T));
+    }
+    offset += count * sizeof(T);
+  }
+
+  template <RawSnapshot T> inline void Read(T &value) { ReadRaw(&value, 1); }
+  template <typename T> inline void Read(T *&pointer) {
+    uintptr_t address = 0;
+    ReadRaw(&address, 1);
+    if (!failed) {
+      pointer = reinterpret_cast<T *>(address);
+    }
+  }
+  void Read(Entity &entity);
+  inline void Read(std::string &string) {
+    uint32_t length = 0;
+    Read(length);
+    if (!failed && length <= snapshot.size() - offset) {
+      string.resize(length);
+      ReadRaw(string.data(), length);
+    } else {
+      failed = true;
+    }
+  }
+  template <typename T> inline void Read(std::vector<T> &values) {
+    uint32_t count = 0;
+    Read(count);
+    if (failed || count > snapshot.size() - offset) { // Every element takes at least one byte
+      failed = true;
+      return;
+    }
+    values.resize(count);
+    if constexpr (RawSnapshot<T>) {
+      ReadRaw(values.data(), count);
+    } else {
+      for (auto &value : values) {
+        Read(value);
+      }
+    }
+  }
+  template <typename... Ts> inline void Read(Ts &...values) requires(sizeof...(Ts) > 1) { (Read(values), ...); }
+
+  inline bool Failed() const { return failed; }
+};
+
+} // namespace Engine::Core
@@ -0,0 +1,61 @@
+#include "SystemScheduler.h"
+
+#include "Debug/Logging.h"
+#include "Debug/Profiling.h"
+
+#include <algorithm>
+
+namespace Engine::Core {
+
+bool SystemScheduler::Conflict(System const &first, System const &second) {
+  return first.exclusive || second.exclusive || (first.writes & (second.reads | second.writes)).Any() ||
+         (second.writes & first.reads).Any();
+}
+
+// Every system goes into the first wave after all earlier systems it conflicts with, which keeps the order in which
+// conflicting systems were added
+void SystemScheduler::BuildWaves(Stage &stage) {
+  std::vector<size_t> waveOf(stage.systems.size(), 0);
+  stage.waves.clear();
+  for (size_t system = 0; system < stage.systems.size(); system++) {
+    for (size_t earlier = 0; earlier < system; earlier++) {
+      if (Conflict(stage.systems[earlier], stage.systems[system])) {
+        waveOf[system] = std::max(waveOf[system], waveOf[earlier] + 1);
+      }
+    }
+    if (waveOf[system] >= stage.waves.size()) {
+      stage.waves.resize(waveOf[system] + 1);
+    }
+    stage.waves[waveOf[system]].push_back(system);
+  }
+  stage.wavesOutdated = false;
+}
+
+void SystemScheduler::Prepare() {
+  for (auto &stage : stages) {
+    if (stage.wavesOutdated) {
+      BuildWaves(stage);
+    }
+  }
+}
+
+void SystemScheduler::RunPrepared(ECS *ecs, Clock const &clock, Util::ThreadPool &pool) const {
+  for (auto const &stage : stages) {
+    ENGINE_ASSERT(!stage.wavesOutdated, "Systems were added after the scheduler was prepared!")
+    for (auto const &wave : stage.waves) {
+      if (wave.size() == 1) {
+        PROFILE_SCOPE(stage.systems[wave.front()].name)
+        stage.systems[wave.front()].run(ecs, clock);
+      } else {
+        PROFILE_SCOPE("Concurrent systems")
+        pool.ParallelFor(wave.size(), [&](size_t i) { stage.systems[wave[i]].run(ecs, clock); });
+      }
+    }
+
+    if (ecs->PlaybackCommands() && stage.onSync) {
+      stage.onSync(ecs);
+    }
+  }
+}
+
+} // namespace Engine::Core
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Core/ECS.h"
+#include "Core/Time.h"
+#include "Util/ThreadPool.h"
+
+#include <functional>
+
+namespace Engine::Core {
+
+template <class... Cs> struct Reads {};
+template <class... Cs> struct Writes {};
+
+// Runs systems in the order they were added, except that systems without conflicting component accesses run
+// concurrently on the thread pool. Two systems conflict if one of them writes a component type the other one reads or
+// writes. Systems must defer structural changes to the command buffers, which are played back at the sync points
+// between groups of systems and after the last one.
+class SystemScheduler {
+public:
+  using SystemFunction = std::function<void(ECS *ecs, Clock const &clock)>;
+  using SyncFunction = std::function<void(ECS *ecs)>;
+
+private:
+  struct System {
+    const char *name;
+    ComponentMask reads;
+    ComponentMask writes;
+    bool exclusive;
+    SystemFunction run;
+  };
+
+  // Systems between two sync points
+  struct Stage {
+    std::vector<System> systems;
+    std::vector<std::vector<size_t>> waves; // Indices of systems that can run at the same time, in order
+    bool wavesOutdated = true;
+    SyncFunction onSync; // Called after commands have been played back at the end of the stage
+  };
+
+  std::vector<Stage> stages;
+
+  static bool Conflict(System const &first, System const &second);
+  static void BuildWaves(Stage &stage);
+
+  template <class... Cs> static inline ComponentMask MaskOf(Reads<Cs...>) {
+    return (get_flag<Cs>() | ... | ComponentMask());
+  }
+  template <class... Cs> static inline ComponentMask MaskOf(Writes<Cs...>) {
+    return (get_flag<Cs>() | ... | ComponentMask());
+  }
+
+public:
+  SystemScheduler() : stages(1) {}
+
+  // Component types have to be registered before systems using them are added
+  template <class R = Reads<>, class W = Writes<>> inline void AddSystem(const char *name, SystemFunction run) {
+    stages.back().systems.push_back(System{name, MaskOf(R{}), MaskOf(W{}), false, std::move(run)});
+    stages.back().wavesOutdated = true;
+  }
+  // For systems whose accesses aren't known up front (e.g. scripts), they conflict with all others
+  inline void AddExclusiveSystem(const char *name, SystemFunction run) {
+    stages.back().systems.push_back(System{name, ComponentMask(), ComponentMask(), true, std::move(run)});
+    stages.back().wavesOutdated = true;
+  }
+  // Systems added after the sync point see the structural changes of the ones before
+  inline void AddSyncPoint(SyncFunction onSync = {}) {
+    stages.back().onSync = std::move(onSync);
+    stages.emplace_back();
+  }
+
+  // Orders the systems added since the last call
+  void Prepare();
+  inline void Run(ECS *ecs, Clock const &clock, Util::ThreadPool &pool = Util::ThreadPool::Shared()) {
+    Prepare();
+    RunPrepared(ecs, clock, pool);
+  }
+  // Only reads the scheduler, so after Prepare it can run the systems on several ECSs concurrently. All state of a run
+  // lives in its ECS and clock; the system and sync functions are shared, so their captures must be thread-safe.
+  void RunPrepared(ECS *ecs, Clock const &clock, Util::ThreadPool &pool = Util::ThreadPool::Shared()) const;
+};
+
+} // namespace Engine::Core
@@ -3,15 +3,18 @@
 #include "Logging.h"
 
 #include <fstream>
+#include <mutex>
 
 #define JSON_PARAM(name, value) << "    \"" name "\": \"" << value << "\""
 
 std::chrono::time_point<std::chrono::steady_clock> _init_time = std::chrono::steady_clock::now();
+std::mutex _profiles_mutex; // Timers may die on worker threads, e.g. in systems of concurrently updated scenes
 
 Engine::Debug::Profiling::LifeTimer::LifeTimer(const char * title) : title(title), birth(std::chrono::steady_clock::now()) { }
 
 Engine::Debug::Profiling::LifeTimer::~LifeTimer() { 
     int64_t lifetime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - birth).count();
+    std::lock_guard lock(_profiles_mutex);
     __profiles.push_back(Profile {
         .name = title,
         .start = std::chrono::duration_cast<std::chrono::microseconds>(birth - _init_time).count(),
@@ -35,7 +35,7 @@ Game::Game(const char *name, Engine::Graphics::VulkanSuite
                *vulkan)
     : mainDeletionQueue(), assetManager(), vulkan(vulkan), shaderCompiler(&vulkan->instanceManager),
       renderingStrategy(nullptr), renderer(&vulkan->instanceManager), activeScene(nullptr), rendering(true),
-      running(true), clock() {
+      running(true), parallelScripts(false), clock() {
 }
 
 template <typename AssetType, typename... RegistrationArgs>
@@ -56,6 +56,33 @@ void Game::Init() {
   Core::ECS::RegisterComponent<Engine::Graphics::Camera>();
   Core::ECS::RegisterComponent<Engine::Core::ScriptComponent>();
 
+  // Scripts may access any component, so nothing runs alongside them
+  systems.AddExclusiveSystem("UpdateScripts", [this](Core::ECS *ecs, Core::Clock const &clock) {
+    if (parallelScripts) {
+      ecs->ParallelForEach<Core::ScriptComponent>(
+          [&clock](Core::ScriptComponent *scriptComponent) { scriptComponent->UpdateScripts(clock); });
+    } else {
+      for (auto [scriptComponent] : ecs->Query<Core::ScriptComponent>()) {
+        scriptComponent->UpdateScripts(clock);
+      }
+    }
+  });
+  systems.AddSyncPoint();
+  // Recalculates the world matrices of moved transforms once, before anything reads them concurrently
+  systems.AddSystem<Core::Reads<>, Core::Writes<Graphics::Transform>>(
+      "UpdateTransforms", [](Core::ECS *ecs, Core::Clock const &) { Graphics::Transform::UpdateWorldMatrices(ecs); });
+  systems.AddSystem<Core::Reads<Graphics::MeshRenderer, Graphics::Transform>>(
+      "GatherMeshRenderers", [this](Core::ECS *ecs, Core::Clock const &) {
+        if (!rendering) {
+          return;
+        }
+        // Renderers below inactive parents are skipped by the mask test of the query
+        Core::With<Graphics::Transform, Core::ActiveInHierarchy> visible{};
+        meshRenderers.resize(ecs->Query<Graphics::MeshRenderer>(visible).Size());
+        ecs->ParallelForEach<Graphics::MeshRenderer>(
+            [this](size_t i, Graphics::MeshRenderer *meshRenderer) { meshRenderers[i] = meshRenderer; }, visible);
+      });
+
   if (!assetManager.IsRegistered<Graphics::Texture2D>()) {
     assetManager.RegisterAssetType<Graphics::Texture2D>(TextureLoader(&vulkan->gpuObjectManager, &assetManager),
                                                         TextureCache(&vulkan->gpuObjectManager));
@@ -105,23 +132,13 @@ void Game::CalculateFrame() {
     PROFILE_FUNCTION()
 
     clock.Update();
+    activeScene->ecs.AdvanceVersion();
 
     Engine::WindowManager::HandleEventsOnAllWindows();
 
-    auto scripts = activeScene->ecs.FilterEntities<Engine::Core::ScriptComponent>();
-    for (auto &[scriptComponent] : scripts) {
-      scriptComponent->UpdateScripts(clock);
-    }
+    systems.Run(&activeScene->ecs, clock);
 
     if (rendering) {
-      auto renderersWithTransforms =
-          activeScene->ecs.FilterEntities<Engine::Graphics::MeshRenderer, Engine::Graphics::Transform>();
-      std::vector<Engine::Graphics::MeshRenderer const *> meshRenderers{};
-      meshRenderers.reserve(renderersWithTransforms.size());
-      for (auto &[meshRenderer, transform] : renderersWithTransforms) {
-        if (!transform->HasInactiveParent())
-          meshRenderers.push_back(meshRenderer);
-      }
       Engine::Graphics::RenderingRequest request{
           .objectsToDraw = meshRenderers,
           .camera = activeScene->mainCamera.GetComponent<Engine::Graphics::Camera>(),
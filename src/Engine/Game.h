@@ -3,6 +3,7 @@
 #include "AssetManager.h"
 #include "Core/ECS.h"
 #include "Core/Scene.h"
+#include "Core/SystemScheduler.h"
 #include "Core/Time.h"
 #include "Graphics/InstanceManager.h"
 #include "Graphics/MemoryAllocator.h"
@@ -26,9 +27,13 @@ struct Game {
   Engine::Graphics::Renderer renderer;
   Engine::Graphics::RenderingStrategy *renderingStrategy;
   Engine::Core::Clock clock;
+  Engine::Core::SystemScheduler systems;
+  std::vector<Engine::Graphics::MeshRenderer const *> meshRenderers; // Filled by the GatherMeshRenderers system
 
   bool rendering;
   bool running;
+  // Scripts may only run in parallel if they defer all structural changes to Entity::Commands()
+  bool parallelScripts;
 
   const char *name;
 
@@ -11,6 +11,8 @@ struct Camera : public Core::Component {
   }
 
   void CopyFrom(Core::Component const *other) override;
+  inline void Serialize(Core::SnapshotWriter &writer) const { writer.Write(projection); }
+  inline void Deserialize(Core::SnapshotReader &reader) { reader.Read(projection); }
 };
 
 } // namespace Engine::Graphics
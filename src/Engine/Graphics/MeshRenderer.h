@@ -49,6 +49,17 @@ public:
     mesh = other.mesh;
     material = other.material;
   }
+  // Assets are referenced by address, so snapshots of mesh renderers only stay valid while the assets are loaded
+  inline void Serialize(Core::SnapshotWriter &writer) const {
+    writer.Write(static_cast<AllocatedMesh const *>(mesh), static_cast<Material const *>(material));
+  }
+  inline void Deserialize(Core::SnapshotReader &reader) {
+    AllocatedMesh *loadedMesh = nullptr;
+    Material *loadedMaterial = nullptr;
+    reader.Read(loadedMesh, loadedMaterial);
+    mesh = loadedMesh;
+    material = loadedMaterial;
+  }
 };
 
 // Implementations
@@ -32,8 +32,8 @@ void DrawSingleMesh(VkCommandBuffer const &commandBuffer, DescriptorAllocator &d
   material->Bind(commandBuffer, descriptorAllocator, descriptorWriter, uniformBuffer);
 
   // Upload uniform data
+  // Shaders only take the model matrix so far; Transform::NormalMatrix() gives the normal matrix once they need it
   Maths::Matrix4 model = renderInfo->entity.GetComponent<Transform>()->ModelToWorldMatrix();
-  Maths::Matrix4 normals = renderInfo->entity.GetComponent<Transform>()->ModelToWorldMatrix().Inverse().Transposed();
   PushConstantsAggregate data{};
   data.PushData(&model);
   mesh->AppendData(data);
@@ -3,7 +3,9 @@
 #include <string>
 
 #include "Core/HierarchyComponent.h"
+#include "Core/SceneHierarchy.h"
 #include "Debug/Logging.h"
+#include "Maths/Matrix3x4.h"
 #include "Maths/Transformations.h"
 #include "json-parsing.h"
 
@@ -15,35 +17,92 @@ struct Transform : public Core::HierarchicalComponent<Transform> {
   Quaternion rotation;
   Vector3 scale;
 
-  Transform *parent;
+private:
+  // Recalculated on access once the transform (local and world) or one of its parents (world only) changed. A dirty
+  // world matrix implies dirty world matrices of all children, so marking can stop at the first dirty one.
+  mutable Matrix3x4 modelToParent;
+  mutable Matrix3x4 modelToWorld;
+  mutable Quaternion worldRotation;
+  mutable bool localDirty;
+  mutable bool worldDirty;
 
+  inline void MarkWorldDirty();
+  inline void UpdateWorld() const { UpdateWorld(Parent()); }
+  inline void UpdateWorld(Transform const *parentTransform) const;
+
+public:
   Transform(Core::Entity entity)
       : Core::HierarchicalComponent<Transform>(entity), position(Vector3::Zero()), rotation(Quaternion::Identity()),
-        scale(Vector3::One()), parent(nullptr) {}
-
-  inline void SetParent(Transform *newParent, bool recalculateTransform = true);
+        scale(Vector3::One()), modelToParent(Matrix3x4::Identity()), modelToWorld(Matrix3x4::Identity()),
+        worldRotation(Quaternion::Identity()), localDirty(true), worldDirty(true) {}
+
+  // The parent is the Transform of the hierarchy parent, so that entities attached while loading or copying a
+  // hierarchy need no fix-up. A hierarchy parent without a Transform (or none) makes this transform a root.
+  inline Transform *Parent() const {
+    Core::Entity const &parent = Hierarchy()->parent;
+    return parent.IsAlive() && parent.HasComponent<Transform>() ? parent.GetComponent<Transform>() : nullptr;
+  }
+  // Reparents the entity in its hierarchy, keeping the world transform
+  inline void SetParent(Transform *newParent) { Hierarchy()->SetParent(newParent ? newParent->Hierarchy() : nullptr); }
 
-  inline void LookAt(Vector3 const &target, Vector3 const &up) { rotation = Quaternion::LookAt(position, target, up); }
+  // Direct writes to position, rotation or scale have to be marked as changes on the entity
+  inline void LookAt(Vector3 const &target, Vector3 const &up) {
+    rotation = Quaternion::LookAt(position, target, up);
+    entity.MarkChanged<Transform>();
+  }
   // TODO: Use Transform::Up()
   inline void LookAt(Vector3 const &target) { LookAt(target, {0, 1, 0}); }
-  inline void Translate(Vector3 const &translation) { position += translation; }
+  inline void Translate(Vector3 const &translation) {
+    position += translation;
+    entity.MarkChanged<Transform>();
+  }
 
-  inline Matrix4 ModelToParentMatrix() const;
-  inline Matrix4 ParentToModelMatrix() const { return ModelToParentMatrix().Inverse(); }
-  inline Matrix4 ModelToWorldMatrix() const;
-  inline Matrix4 WorldToModelMatrix() const { return ModelToWorldMatrix().Inverse(); }
+  // Called by the ECS whenever the transform is marked as changed. Also marks all children, so transforms within one
+  // hierarchy must not be marked from several threads at once.
+  inline void OnChanged() {
+    localDirty = true;
+    MarkWorldDirty();
+  }
 
-  inline Vector3 WorldPosition() const {
-    return (ModelToWorldMatrix() * Vector4{position[X], position[Y], position[Z], 1}).xyz();
+  // Children lose this transform as their parent, whether it is removed alone or with its entity
+  inline void OnRemove() {
+    for (auto const &child : Hierarchy()->children) {
+      if (child.IsAlive() && child.HasComponent<Transform>()) {
+        child.MarkChanged<Transform>();
+      }
+    }
   }
-  inline Quaternion WorldRotation() const;
 
-  inline bool HasInactiveParent() const {
-    if (parent) {
-      return !parent->entity.IsActive() || parent->HasInactiveParent();
-    } else {
-      return false;
+  inline Matrix3x4 const &ModelToParentAffine() const;
+  inline Matrix3x4 const &ModelToWorldAffine() const {
+    if (worldDirty) {
+      UpdateWorld();
+    }
+    return modelToWorld;
+  }
+  inline Matrix4 ModelToParentMatrix() const { return ModelToParentAffine().ToMatrix4(); }
+  // The local matrix has no shear, so it can be inverted by transposing the rotation
+  inline Matrix4 ParentToModelMatrix() const { return ModelToParentAffine().InverseTRS().ToMatrix4(); }
+  inline Matrix4 ModelToWorldMatrix() const { return ModelToWorldAffine().ToMatrix4(); }
+  inline Matrix4 WorldToModelMatrix() const { return ModelToWorldAffine().Inverse().ToMatrix4(); }
+  // Inverse-transpose of the world matrix, for transforming normals
+  inline Matrix3 NormalMatrix() const { return ModelToWorldAffine().NormalMatrix(); }
+
+  inline Vector3 WorldPosition() const { return ModelToWorldAffine().Translation(); }
+  inline Quaternion const &WorldRotation() const {
+    if (worldDirty) {
+      UpdateWorld();
     }
+    return worldRotation;
+  }
+  // Brings all world matrices up to date, so that they can be read concurrently. With a SceneHierarchy resource, the
+  // flattened hierarchy is updated level by level, the transforms of one level in parallel.
+  static inline void UpdateWorldMatrices(Core::ECS *ecs);
+
+  // Filtering by With<Core::ActiveInHierarchy> is cheaper than checking every transform
+  inline bool HasInactiveParent() const {
+    Core::Entity const &parent = Hierarchy()->parent;
+    return parent.IsAlive() && !parent.IsActiveInHierarchy();
   }
 
   inline void CopyFrom(Transform const &other) override {
@@ -52,65 +111,99 @@ struct Transform : public Core::HierarchicalComponent<Transform> {
     scale = other.scale;
   }
 
-  inline void OnHierarchyChange() override { SetParent(hierarchy->parent->entity.GetComponent<Transform>(), true); }
+  // The parent is part of the HierarchyComponent's snapshot
+  inline void Serialize(Core::SnapshotWriter &writer) const { writer.Write(position, rotation, scale); }
+  inline void Deserialize(Core::SnapshotReader &reader) { reader.Read(position, rotation, scale); }
+
+  inline void OnHierarchyChange(Core::Entity const &newParent) override;
 };
 
-// Scale is not adjusted as by stacking scales and rotation, shearing is possible (which cannot be represented as a
-// Vector3)
-inline void Transform::SetParent(Transform *newParent, bool recaltulateTransform) {
-  // Remove from old parent
-  if (recaltulateTransform) {
-    position = WorldPosition();
-    rotation = WorldRotation();
+// Rewrites the local values relative to the new parent, while the old one is still in place. Scale is not adjusted as
+// by stacking scales and rotation, shearing is possible (which cannot be represented as a Vector3)
+inline void Transform::OnHierarchyChange(Core::Entity const &newParent) {
+  position = WorldPosition();
+  rotation = WorldRotation();
+
+  // A parent without a Transform (or none, after SetParent(nullptr)) leaves this transform at the root
+  if (newParent.IsAlive() && newParent.HasComponent<Transform>()) {
+    Transform const *newParentTransform = newParent.GetComponent<Transform>();
+    position = newParentTransform->ModelToWorldAffine().Inverse().TransformPoint(position);
+    rotation = newParentTransform->WorldRotation().Conjugate() * rotation;
   }
+  entity.MarkChanged<Transform>();
+}
 
-  // Add to new parent
-  parent = newParent;
-  if (recaltulateTransform) {
-    position = (parent->WorldToModelMatrix() * Vector4{position[X], position[Y], position[Z], 1}).xyz();
-    rotation *= parent->WorldRotation().Conjugate();
+void Transform::MarkWorldDirty() {
+  if (worldDirty) {
+    return;
+  }
+  worldDirty = true;
+  for (auto const &child : Hierarchy()->children) {
+    if (child.HasComponent<Transform>()) {
+      child.GetComponent<Transform>()->MarkWorldDirty();
+    }
   }
 }
 
-Matrix4 Transform::ModelToParentMatrix() const {
-  {
-    Matrix3 R = rotation.RotationMatrix();
-    return Matrix4{scale[X] * R[0][0],
-                   scale[Y] * R[0][1],
-                   scale[Z] * R[0][2],
-                   position[X],
-
-                   scale[X] * R[1][0],
-                   scale[Y] * R[1][1],
-                   scale[Z] * R[1][2],
-                   position[Y],
-
-                   scale[X] * R[2][0],
-                   scale[Y] * R[2][1],
-                   scale[Z] * R[2][2],
-                   position[Z],
-
-                   0,
-                   0,
-                   0,
-                   1};
+void Transform::UpdateWorld(Transform const *parentTransform) const {
+  if (parentTransform) {
+    modelToWorld = parentTransform->ModelToWorldAffine() * ModelToParentAffine();
+    worldRotation = parentTransform->WorldRotation() * rotation;
+  } else {
+    modelToWorld = ModelToParentAffine();
+    worldRotation = rotation;
   }
+  worldDirty = false;
 }
 
-Matrix4 Transform::ModelToWorldMatrix() const {
-  if (parent) {
-    return parent->ModelToWorldMatrix() * ModelToParentMatrix();
-  } else {
-    return ModelToParentMatrix();
+void Transform::UpdateWorldMatrices(Core::ECS *ecs) {
+  auto hierarchy = ecs->GetResource<Core::SceneHierarchy>();
+  if (!hierarchy) {
+    for (auto [transform] : ecs->Query<Transform>()) {
+      transform->ModelToWorldAffine();
+    }
+    return;
+  }
+
+  // Transforms are resolved once, so that children find their parents by index
+  auto const &flattened = hierarchy->Flatten();
+  std::vector<Transform *> transforms(flattened.entities.size());
+  auto forEachChunk = [](size_t begin, size_t end, auto const &fn) {
+    constexpr size_t grainSize = std::max<size_t>(PARALLEL_CHUNK_BYTES / sizeof(Transform), 1);
+    if (end - begin <= grainSize) {
+      fn(begin, end);
+      return;
+    }
+    Util::ThreadPool::Shared().ParallelFor((end - begin + grainSize - 1) / grainSize, [&](size_t chunk) {
+      fn(begin + chunk * grainSize, std::min(begin + (chunk + 1) * grainSize, end));
+    });
+  };
+  forEachChunk(0, transforms.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      Core::Entity const &e = flattened.entities[i];
+      transforms[i] = e.HasComponent<Transform>() ? e.GetComponent<Transform>() : nullptr;
+    }
+  });
+
+  // The flattened parents are the hierarchy parents that Parent() resolves, so the result matches lazy evaluation
+  for (size_t level = 0; level < flattened.LevelCount(); level++) {
+    forEachChunk(flattened.LevelBegin(level), flattened.LevelEnd(level), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        if (transforms[i] && transforms[i]->worldDirty) {
+          uint32_t parentIndex = flattened.parents[i];
+          transforms[i]->UpdateWorld(parentIndex == flattened.NO_PARENT ? nullptr : transforms[parentIndex]);
+        }
+      }
+    });
   }
 }
 
-Quaternion Transform::WorldRotation() const {
-  if (parent) {
-    return parent->WorldRotation() * rotation;
-  } else {
-    return rotation;
+Matrix3x4 const &Transform::ModelToParentAffine() const {
+  if (localDirty) {
+    modelToParent = Matrix3x4::FromTRS(position, rotation, scale);
+    localDirty = false;
   }
+  return modelToParent;
 }
 
 } // namespace Engine::Graphics
\ No newline at end of file
@@ -0,0 +1,503 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "Matrix3x4.h"
+#include "SIMD.h"
+#include "Transformations.h"
+#include "Util/ThreadPool.h"
+
+#define BATCH_CHUNK_SIZE 4096 // Elements per thread pool job, so that dispatching is cheap compared to the work
+
+// Operations on whole streams of vectors and matrices rather than single values. Vectors are passed as structures of
+// arrays, so that SIMD lanes hold the same coordinate of consecutive vectors. Every operation can be split across a
+// thread pool; without one, it runs on the calling thread.
+namespace Engine::Maths::Batch {
+
+// x, y and z coordinates of Size() vectors, in separate arrays of equal length
+template <typename T> struct Vector3SpanT {
+  std::span<T> x, y, z;
+
+  inline size_t Size() const { return x.size(); }
+  inline Vector3 Get(size_t i) const { return {x[i], y[i], z[i]}; }
+  inline void Set(size_t i, Vector3 const &v) const
+    requires(!std::is_const_v<T>)
+  {
+    x[i] = v[X];
+    y[i] = v[Y];
+    z[i] = v[Z];
+  }
+  inline operator Vector3SpanT<T const>() const { return {x, y, z}; }
+};
+using Vector3Span = Vector3SpanT<float>;
+using ConstVector3Span = Vector3SpanT<float const>;
+
+// Owns the arrays behind a Vector3Span
+struct Vector3Array {
+  std::vector<float> x, y, z;
+
+  Vector3Array(size_t size = 0) : x(size), y(size), z(size) {}
+
+  inline size_t Size() const { return x.size(); }
+  inline Vector3 Get(size_t i) const { return {x[i], y[i], z[i]}; }
+  inline void Set(size_t i, Vector3 const &v) { Span().Set(i, v); }
+  inline Vector3Span Span() { return {x, y, z}; }
+  inline ConstVector3Span Span() const { return {x, y, z}; }
+  inline operator Vector3Span() { return Span(); }
+  inline operator ConstVector3Span() const { return Span(); }
+};
+
+// w, x, y and z of Size() quaternions, in separate arrays of equal length
+template <typename T> struct QuaternionSpanT {
+  std::span<T> w, x, y, z;
+
+  inline size_t Size() const { return w.size(); }
+  inline Quaternion Get(size_t i) const { return {w[i], x[i], y[i], z[i]}; }
+  inline void Set(size_t i, Quaternion const &q) const
+    requires(!std::is_const_v<T>)
+  {
+    w[i] = q.w;
+    x[i] = q.x;
+    y[i] = q.y;
+    z[i] = q.z;
+  }
+  inline operator QuaternionSpanT<T const>() const { return {w, x, y, z}; }
+};
+using QuaternionSpan = QuaternionSpanT<float>;
+using ConstQuaternionSpan = QuaternionSpanT<float const>;
+
+// Owns the arrays behind a QuaternionSpan
+struct QuaternionArray {
+  std::vector<float> w, x, y, z;
+
+  QuaternionArray(size_t size = 0) : w(size), x(size), y(size), z(size) {}
+
+  inline size_t Size() const { return w.size(); }
+  inline Quaternion Get(size_t i) const { return {w[i], x[i], y[i], z[i]}; }
+  inline void Set(size_t i, Quaternion const &q) { Span().Set(i, q); }
+  inline QuaternionSpan Span() { return {w, x, y, z}; }
+  inline ConstQuaternionSpan Span() const { return {w, x, y, z}; }
+  inline operator QuaternionSpan() { return Span(); }
+  inline operator ConstQuaternionSpan() const { return Span(); }
+};
+
+// Axis-aligned boxes, min and max corners as separate vector streams
+template <typename T> struct BoundingBoxSpanT {
+  Vector3SpanT<T> min, max;
+
+  inline size_t Size() const { return min.Size(); }
+  inline operator BoundingBoxSpanT<T const>() const { return {min, max}; }
+};
+using BoundingBoxSpan = BoundingBoxSpanT<float>;
+using ConstBoundingBoxSpan = BoundingBoxSpanT<float const>;
+
+// Calls fn(begin, end) for chunks of [0, count), on the pool if there is one and more than one chunk
+template <typename Fn> inline void ForEachChunk(size_t count, Util::ThreadPool *pool, Fn const &fn) {
+  if (!pool || count <= BATCH_CHUNK_SIZE) {
+    fn(size_t(0), count);
+    return;
+  }
+  pool->ParallelFor((count + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE, [&](size_t chunk) {
+    fn(chunk * BATCH_CHUNK_SIZE, std::min((chunk + 1) * BATCH_CHUNK_SIZE, count));
+  });
+}
+
+// result[i] = matrix * (points[i], 1). result may be points.
+inline void TransformPoints(Matrix3x4 const &matrix, ConstVector3Span points, Vector3Span result,
+                            Util::ThreadPool *pool = nullptr) {
+  float const *m = matrix.data.data();
+  ForEachChunk(points.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    __m128 column[12];
+    for (int j = 0; j < 12; j++) {
+      column[j] = _mm_set1_ps(m[j]);
+    }
+    for (; i + 4 <= end; i += 4) {
+      __m128 x = _mm_loadu_ps(&points.x[i]), y = _mm_loadu_ps(&points.y[i]), z = _mm_loadu_ps(&points.z[i]);
+      for (int row = 0; row < 3; row++) {
+        __m128 value = _mm_add_ps(_mm_mul_ps(column[row], x), _mm_mul_ps(column[3 + row], y));
+        value = _mm_add_ps(_mm_add_ps(value, _mm_mul_ps(column[6 + row], z)), column[9 + row]);
+        _mm_storeu_ps(&(row == 0 ? result.x : row == 1 ? result.y : result.z)[i], value);
+      }
+    }
+#endif
+    for (; i < end; i++) {
+      float x = points.x[i], y = points.y[i], z = points.z[i];
+      result.x[i] = m[0] * x + m[3] * y + m[6] * z + m[9];
+      result.y[i] = m[1] * x + m[4] * y + m[7] * z + m[10];
+      result.z[i] = m[2] * x + m[5] * y + m[8] * z + m[11];
+    }
+  });
+}
+
+// Divides every vector by its length, like Vector3::Normalized. result may be vectors.
+inline void Normalize(ConstVector3Span vectors, Vector3Span result, Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(vectors.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    for (; i + 4 <= end; i += 4) {
+      __m128 x = _mm_loadu_ps(&vectors.x[i]), y = _mm_loadu_ps(&vectors.y[i]), z = _mm_loadu_ps(&vectors.z[i]);
+      __m128 sqrMagnitude = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+      __m128 length = _mm_sqrt_ps(sqrMagnitude);
+      _mm_storeu_ps(&result.x[i], _mm_div_ps(x, length));
+      _mm_storeu_ps(&result.y[i], _mm_div_ps(y, length));
+      _mm_storeu_ps(&result.z[i], _mm_div_ps(z, length));
+    }
+#endif
+    for (; i < end; i++) {
+      float x = vectors.x[i], y = vectors.y[i], z = vectors.z[i];
+      float length = std::sqrt(x * x + y * y + z * z);
+      result.x[i] = x / length;
+      result.y[i] = y / length;
+      result.z[i] = z / length;
+    }
+  });
+}
+
+// Shared by the overloads of Multiply
+template <typename M>
+inline void MultiplyPairs(std::span<M const> a, std::span<M const> b, std::span<M> result, Util::ThreadPool *pool) {
+  ForEachChunk(a.size(), pool, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      result[i] = a[i] * b[i];
+    }
+  });
+}
+
+// result[i] = a[i] * b[i]. The products already run on the SIMD kernels of the matrix types, batches add threading.
+inline void Multiply(std::span<Matrix4 const> a, std::span<Matrix4 const> b, std::span<Matrix4> result,
+                     Util::ThreadPool *pool = nullptr) {
+  MultiplyPairs(a, b, result, pool);
+}
+inline void Multiply(std::span<Matrix3x4 const> a, std::span<Matrix3x4 const> b, std::span<Matrix3x4> result,
+                     Util::ThreadPool *pool = nullptr) {
+  MultiplyPairs(a, b, result, pool);
+}
+
+// result[i] is the axis-aligned box around boxes[i] transformed by matrices[i], e.g. the world space bounds of
+// meshes for culling. The extents are mapped through the absolute values of the linear parts (Arvo's method).
+inline void TransformBoundingBoxes(std::span<Matrix3x4 const> matrices, ConstBoundingBoxSpan boxes,
+                                   BoundingBoxSpan result, Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(boxes.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (; i + 4 <= end; i += 4) {
+      // Entry j of the four matrices
+      __m128 m[12];
+      for (int j = 0; j < 12; j++) {
+        m[j] = _mm_setr_ps(matrices[i].data[j], matrices[i + 1].data[j], matrices[i + 2].data[j],
+                           matrices[i + 3].data[j]);
+      }
+      __m128 center[3], extent[3];
+      for (int k = 0; k < 3; k++) {
+        std::span<float const> min = k == 0 ? boxes.min.x : k == 1 ? boxes.min.y : boxes.min.z;
+        std::span<float const> max = k == 0 ? boxes.max.x : k == 1 ? boxes.max.y : boxes.max.z;
+        __m128 lower = _mm_loadu_ps(&min[i]), upper = _mm_loadu_ps(&max[i]);
+        center[k] = _mm_mul_ps(_mm_add_ps(lower, upper), half);
+        extent[k] = _mm_mul_ps(_mm_sub_ps(upper, lower), half);
+      }
+      for (int row = 0; row < 3; row++) {
+        __m128 c = m[9 + row], e = _mm_setzero_ps();
+        for (int k = 0; k < 3; k++) {
+          c = _mm_add_ps(c, _mm_mul_ps(m[k * 3 + row], center[k]));
+          e = _mm_add_ps(e, _mm_mul_ps(_mm_and_ps(m[k * 3 + row], absMask), extent[k]));
+        }
+        std::span<float> min = row == 0 ? result.min.x : row == 1 ? result.min.y : result.min.z;
+        std::span<float> max = row == 0 ? result.max.x : row == 1 ? result.max.y : result.max.z;
+        _mm_storeu_ps(&min[i], _mm_sub_ps(c, e));
+        _mm_storeu_ps(&max[i], _mm_add_ps(c, e));
+      }
+    }
+#endif
+    for (; i < end; i++) {
+      Vector3 lower = boxes.min.Get(i), upper = boxes.max.Get(i);
+      float center[3], extent[3];
+      for (int k = 0; k < 3; k++) {
+        center[k] = (lower[k] + upper[k]) * 0.5f;
+        extent[k] = (upper[k] - lower[k]) * 0.5f;
+      }
+      float const *m = matrices[i].data.data();
+      float c[3], e[3];
+      for (int row = 0; row < 3; row++) {
+        c[row] = m[9 + row];
+        e[row] = 0;
+        for (int k = 0; k < 3; k++) {
+          c[row] += m[k * 3 + row] * center[k];
+          e[row] += std::abs(m[k * 3 + row]) * extent[k];
+        }
+      }
+      result.min.Set(i, {c[0] - e[0], c[1] - e[1], c[2] - e[2]});
+      result.max.Set(i, {c[0] + e[0], c[1] + e[1], c[2] + e[2]});
+    }
+  });
+}
+
+// +-----------------------------+
+// |    Quaternion operations    |
+// +-----------------------------+
+
+#ifdef MATHS_SIMD_SSE
+// Four quaternions, one component per register
+struct Quaternion4 {
+  __m128 w, x, y, z;
+
+  inline static Quaternion4 Load(ConstQuaternionSpan q, size_t i) {
+    return {_mm_loadu_ps(&q.w[i]), _mm_loadu_ps(&q.x[i]), _mm_loadu_ps(&q.y[i]), _mm_loadu_ps(&q.z[i])};
+  }
+  inline static Quaternion4 Broadcast(Quaternion const &q) {
+    return {_mm_set1_ps(q.w), _mm_set1_ps(q.x), _mm_set1_ps(q.y), _mm_set1_ps(q.z)};
+  }
+  inline void Store(QuaternionSpan q, size_t i) const {
+    _mm_storeu_ps(&q.w[i], w);
+    _mm_storeu_ps(&q.x[i], x);
+    _mm_storeu_ps(&q.y[i], y);
+    _mm_storeu_ps(&q.z[i], z);
+  }
+
+  // Like Quaternion::operator*
+  inline Quaternion4 operator*(Quaternion4 const &o) const {
+    return {_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(w, o.w), _mm_mul_ps(x, o.x)),
+                       _mm_add_ps(_mm_mul_ps(y, o.y), _mm_mul_ps(z, o.z))),
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, o.x), _mm_mul_ps(x, o.w)),
+                       _mm_sub_ps(_mm_mul_ps(y, o.z), _mm_mul_ps(z, o.y))),
+            _mm_add_ps(_mm_sub_ps(_mm_mul_ps(w, o.y), _mm_mul_ps(x, o.z)),
+                       _mm_add_ps(_mm_mul_ps(y, o.w), _mm_mul_ps(z, o.x))),
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, o.z), _mm_mul_ps(x, o.y)),
+                       _mm_sub_ps(_mm_mul_ps(z, o.w), _mm_mul_ps(y, o.x)))};
+  }
+  inline __m128 Dot(Quaternion4 const &o) const {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, o.w), _mm_mul_ps(x, o.x)),
+                      _mm_add_ps(_mm_mul_ps(y, o.y), _mm_mul_ps(z, o.z)));
+  }
+  inline Quaternion4 Normalized() const {
+    __m128 length = _mm_sqrt_ps(Dot(*this));
+    return {_mm_div_ps(w, length), _mm_div_ps(x, length), _mm_div_ps(y, length), _mm_div_ps(z, length)};
+  }
+  // a * this + b * other
+  inline Quaternion4 Combine(__m128 a, Quaternion4 const &o, __m128 b) const {
+    return {_mm_add_ps(_mm_mul_ps(a, w), _mm_mul_ps(b, o.w)), _mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, o.x)),
+            _mm_add_ps(_mm_mul_ps(a, y), _mm_mul_ps(b, o.y)), _mm_add_ps(_mm_mul_ps(a, z), _mm_mul_ps(b, o.z))};
+  }
+
+  // The entries of RotationMatrix, in the row form it is written in
+  inline void RotationEntries(__m128 *entries) const {
+    __m128 two = _mm_set1_ps(2);
+    __m128 ww = _mm_mul_ps(w, w), xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+    entries[0] = _mm_sub_ps(_mm_add_ps(ww, xx), _mm_add_ps(yy, zz));
+    entries[1] = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+    entries[2] = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+    entries[3] = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+    entries[4] = _mm_sub_ps(_mm_add_ps(ww, yy), _mm_add_ps(xx, zz));
+    entries[5] = _mm_mul_ps(two, _mm_add_ps(wx, yz));
+    entries[6] = _mm_mul_ps(two, _mm_add_ps(wy, xz));
+    entries[7] = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+    entries[8] = _mm_sub_ps(_mm_add_ps(ww, zz), _mm_add_ps(xx, yy));
+  }
+};
+#endif
+
+// result[i] = a[i] * b[i]. result may be a or b.
+inline void Multiply(ConstQuaternionSpan a, ConstQuaternionSpan b, QuaternionSpan result,
+                     Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(a.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    for (; i + 4 <= end; i += 4) {
+      (Quaternion4::Load(a, i) * Quaternion4::Load(b, i)).Store(result, i);
+    }
+#endif
+    for (; i < end; i++) {
+      result.Set(i, a.Get(i) * b.Get(i));
+    }
+  });
+}
+
+// result[i] = rotation * q[i], e.g. to turn many objects by the same amount. result may be q.
+inline void Multiply(Quaternion const &rotation, ConstQuaternionSpan q, QuaternionSpan result,
+                     Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(q.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    Quaternion4 r = Quaternion4::Broadcast(rotation);
+    for (; i + 4 <= end; i += 4) {
+      (r * Quaternion4::Load(q, i)).Store(result, i);
+    }
+#endif
+    for (; i < end; i++) {
+      result.Set(i, rotation * q.Get(i));
+    }
+  });
+}
+
+// Like Quaternion::Normalized. result may be q.
+inline void Normalize(ConstQuaternionSpan q, QuaternionSpan result, Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(q.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    for (; i + 4 <= end; i += 4) {
+      Quaternion4::Load(q, i).Normalized().Store(result, i);
+    }
+#endif
+    for (; i < end; i++) {
+      result.Set(i, q.Get(i).Normalized());
+    }
+  });
+}
+
+// result[i] = Quaternion::Nlerp(a[i], b[i], t). result may be a or b.
+inline void Nlerp(ConstQuaternionSpan a, ConstQuaternionSpan b, float t, QuaternionSpan result,
+                  Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(a.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    __m128 ta = _mm_set1_ps(1 - t), tb = _mm_set1_ps(t), signMask = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= end; i += 4) {
+      Quaternion4 qa = Quaternion4::Load(a, i), qb = Quaternion4::Load(b, i);
+      __m128 sign = _mm_and_ps(qa.Dot(qb), signMask); // Flips t for the longer arcs
+      qa.Combine(ta, qb, _mm_xor_ps(tb, sign)).Normalized().Store(result, i);
+    }
+#endif
+    for (; i < end; i++) {
+      result.Set(i, Quaternion::Nlerp(a.Get(i), b.Get(i), t));
+    }
+  });
+}
+
+// result[i] = Quaternion::Slerp(a[i], b[i], t), up to rounding. The angles are taken per element, only the weighted
+// sums run in SIMD registers. result may be a or b.
+inline void Slerp(ConstQuaternionSpan a, ConstQuaternionSpan b, float t, QuaternionSpan result,
+                  Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(a.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    for (; i + 4 <= end; i += 4) {
+      Quaternion4 qa = Quaternion4::Load(a, i), qb = Quaternion4::Load(b, i);
+      alignas(16) float cosTheta[4], weightA[4], weightB[4];
+      _mm_store_ps(cosTheta, qa.Dot(qb));
+      bool nlerp = false;
+      for (int k = 0; k < 4; k++) {
+        float sign = cosTheta[k] < 0 ? -1.0f : 1.0f;
+        float cosine = cosTheta[k] * sign;
+        if (cosine > QUATERNION_SLERP_THRESHOLD) {
+          weightA[k] = 1 - t;
+          weightB[k] = sign * t;
+          nlerp = true;
+        } else {
+          float theta = std::acos(cosine), sinTheta = std::sin(theta);
+          weightA[k] = std::sin((1 - t) * theta) / sinTheta;
+          weightB[k] = sign * std::sin(t * theta) / sinTheta;
+        }
+      }
+      Quaternion4 q = qa.Combine(_mm_load_ps(weightA), qb, _mm_load_ps(weightB));
+      (nlerp ? q.Normalized() : q).Store(result, i);
+    }
+#endif
+    for (; i < end; i++) {
+      result.Set(i, Quaternion::Slerp(a.Get(i), b.Get(i), t));
+    }
+  });
+}
+
+// result[i] = q[i].RotationMatrix()
+inline void RotationMatrices(ConstQuaternionSpan q, std::span<Matrix3> result, Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(q.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    for (; i + 4 <= end; i += 4) {
+      __m128 entries[12];
+      Quaternion4::Load(q, i).RotationEntries(entries);
+      entries[9] = entries[10] = entries[11] = _mm_setzero_ps();
+      // Entries 4 * g to 4 * g + 3 of quaternion k end up in entries[4 * g + k]
+      for (int g = 0; g < 12; g += 4) {
+        _MM_TRANSPOSE4_PS(entries[g], entries[g + 1], entries[g + 2], entries[g + 3]);
+      }
+      for (int k = 0; k < 4; k++) {
+        alignas(16) std::array<float, 12> e;
+        _mm_store_ps(&e[0], entries[k]);
+        _mm_store_ps(&e[4], entries[4 + k]);
+        _mm_store_ps(&e[8], entries[8 + k]);
+        result[i + k] = Matrix3{e[0], e[1], e[2], e[3], e[4], e[5], e[6], e[7], e[8]};
+      }
+    }
+#endif
+    for (; i < end; i++) {
+      result[i] = q.Get(i).RotationMatrix();
+    }
+  });
+}
+
+// result[i] = Matrix3x4::FromTRS(positions[i], rotations[i], scales[i]), the local matrices of transforms
+inline void FromTRS(ConstVector3Span positions, ConstQuaternionSpan rotations, ConstVector3Span scales,
+                    std::span<Matrix3x4> result, Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(rotations.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    for (; i + 4 <= end; i += 4) {
+      // The rows of RotationMatrix are the columns of the rotation, each scaled by its axis
+      __m128 entries[12];
+      Quaternion4::Load(rotations, i).RotationEntries(entries);
+      __m128 scale[3] = {_mm_loadu_ps(&scales.x[i]), _mm_loadu_ps(&scales.y[i]), _mm_loadu_ps(&scales.z[i])};
+      for (int j = 0; j < 9; j++) {
+        entries[j] = _mm_mul_ps(entries[j], scale[j / 3]);
+      }
+      entries[9] = _mm_loadu_ps(&positions.x[i]);
+      entries[10] = _mm_loadu_ps(&positions.y[i]);
+      entries[11] = _mm_loadu_ps(&positions.z[i]);
+      // Matrix3x4 is 16 byte aligned, so every matrix takes three aligned stores
+      for (int g = 0; g < 12; g += 4) {
+        _MM_TRANSPOSE4_PS(entries[g], entries[g + 1], entries[g + 2], entries[g + 3]);
+      }
+      for (int k = 0; k < 4; k++) {
+        float *data = result[i + k].data.data();
+        _mm_store_ps(data, entries[k]);
+        _mm_store_ps(data + 4, entries[4 + k]);
+        _mm_store_ps(data + 8, entries[8 + k]);
+      }
+    }
+#endif
+    for (; i < end; i++) {
+      result[i] = Matrix3x4::FromTRS(positions.Get(i), rotations.Get(i), scales.Get(i));
+    }
+  });
+}
+
+// result[i] = Transformations::RotateByQuaternion(vectors[i], rotations[i]). result may be vectors.
+inline void Rotate(ConstQuaternionSpan rotations, ConstVector3Span vectors, Vector3Span result,
+                   Util::ThreadPool *pool = nullptr) {
+  ForEachChunk(vectors.Size(), pool, [&](size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef MATHS_SIMD_SSE
+    auto cross = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz, __m128 out[3]) {
+      out[0] = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+      out[1] = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+      out[2] = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+    };
+    __m128 two = _mm_set1_ps(2);
+    for (; i + 4 <= end; i += 4) {
+      // v + w t + q.xyz x t with t = 2 q.xyz x v
+      Quaternion4 q = Quaternion4::Load(rotations, i);
+      __m128 v[3] = {_mm_loadu_ps(&vectors.x[i]), _mm_loadu_ps(&vectors.y[i]), _mm_loadu_ps(&vectors.z[i])};
+      __m128 t[3], u[3];
+      cross(q.x, q.y, q.z, v[0], v[1], v[2], t);
+      for (int k = 0; k < 3; k++) {
+        t[k] = _mm_mul_ps(two, t[k]);
+      }
+      cross(q.x, q.y, q.z, t[0], t[1], t[2], u);
+      _mm_storeu_ps(&result.x[i], _mm_add_ps(_mm_add_ps(v[0], _mm_mul_ps(q.w, t[0])), u[0]));
+      _mm_storeu_ps(&result.y[i], _mm_add_ps(_mm_add_ps(v[1], _mm_mul_ps(q.w, t[1])), u[1]));
+      _mm_storeu_ps(&result.z[i], _mm_add_ps(_mm_add_ps(v[2], _mm_mul_ps(q.w, t[2])), u[2]));
+    }
+#endif
+    for (; i < end; i++) {
+      result.Set(i, Transformations::RotateByQuaternion(vectors.Get(i), rotations.Get(i)));
+    }
+  });
+}
+
+} // namespace Engine::Maths::Batch
@@ -6,7 +6,10 @@
 #include <initializer_list>
 #include <sstream>
 #include <stdint.h>
+#include <type_traits>
+#include <utility>
 
+#include "SIMD.h"
 #include "json-parsing.h"
 
 #define PI 3.14159265359
@@ -38,6 +41,10 @@ using Vector2 = Vector<2>;
 using Vector3 = Vector<3>;
 using Vector4 = Vector<4>;
 
+// Lazily evaluated element-wise vector arithmetic, see VectorExpression.h
+template <typename E>
+concept VectorExpression = requires { typename std::remove_cvref_t<E>::IsVectorExpression; };
+
 template <typename T> constexpr uint8_t alignment(uint8_t n, uint8_t m) {
   uint8_t numBytes = n * m * sizeof(T);
   if (numBytes <= 1)
@@ -59,37 +66,57 @@ namespace Engine::Maths {
 // Saved in column form (n x m means m columns, n rows)
 template <uint8_t n, uint8_t m, typename T> struct alignas(alignment<T>(n, m)) MatrixT {
 private:
-  inline void ConvertToColumnForm();
-  MatrixT(bool rowWise, std::array<T, n * m> const &values) : data(values) {
+  constexpr void ConvertToColumnForm();
+  // Entry i of the column form is entry (i % n) * m + i / n of the row form. Unrolled, so that constant matrices are
+  // converted at compile time and others by plain moves.
+  template <size_t... i>
+  constexpr static std::array<T, n * m> ToColumnForm(std::array<T, n * m> const &values, std::index_sequence<i...>) {
+    return {values[(i % n) * m + i / n]...};
+  }
+  constexpr MatrixT(bool rowWise, std::array<T, n * m> const &values) : data(values) {
     if (rowWise)
       ConvertToColumnForm();
   }
   template <typename... _T, typename std::enable_if<sizeof...(_T) == n * m, int>::type = 0>
-  MatrixT(bool rowWise, _T... values) : data({static_cast<T>(values)...}) {
+  constexpr MatrixT(bool rowWise, _T... values) : data({static_cast<T>(values)...}) {
     if (rowWise) // TODO: Figure out how to use other constructor
       ConvertToColumnForm();
   }
+  // Unrolled, so that every element is written once
+  template <typename E, size_t... i>
+  constexpr MatrixT(E const &expression, std::index_sequence<i...>) : data{static_cast<T>(expression[i])...} {}
 
 public:
   // Public constructors always expect data in row form
-  MatrixT(std::array<T, n * m> const &values) : MatrixT(true, values) {}
+  constexpr MatrixT(std::array<T, n * m> const &values) : MatrixT(true, values) {}
   // Public constructors always expect data in row form
   template <typename... _T, typename std::enable_if<sizeof...(_T) == n * m, int>::type = 0>
-  MatrixT(_T... values) : MatrixT(true, values...) {}
-  MatrixT() : data() {}
+  constexpr MatrixT(_T... values) : MatrixT(true, values...) {}
+  constexpr MatrixT() : data() {}
+  // Evaluates a chain of element-wise vector operations in one pass
+  template <VectorExpression E>
+  constexpr MatrixT(E const &expression)
+    requires(m == 1 && E::size == n)
+      : MatrixT(expression, std::make_index_sequence<n>{}) {}
 
   inline bool operator==(MatrixT<n, m, T> const &other) const;
   inline bool operator!=(MatrixT<n, m, T> const &other) const { return !(*this == other); };
 
-  inline MatrixT<n, m, T> operator+(MatrixT<n, m, T> const &other) const;
-  inline MatrixT<n, m, T> operator-(MatrixT<n, m, T> const &other) const;
+  // Element-wise operations of vectors are lazy and declared in VectorExpression.h
+  constexpr MatrixT<n, m, T> operator+(MatrixT<n, m, T> const &other) const
+    requires(m > 1);
+  constexpr MatrixT<n, m, T> operator-(MatrixT<n, m, T> const &other) const
+    requires(m > 1);
   template <typename T2>
-  inline MatrixT<n, m, T> operator+(T2 const &value) const
-    requires(std::is_arithmetic<T2>::value);
+  constexpr MatrixT<n, m, T> operator+(T2 const &value) const
+    requires(std::is_arithmetic<T2>::value && m > 1);
   template <typename T2>
-  inline MatrixT<n, m, T> operator-(T2 const &value) const
-    requires(std::is_arithmetic<T2>::value);
-  template <typename T2> inline friend MatrixT<n, m, T> operator+(T2 const &value, MatrixT<n, m, T> const &matrix) {
+  constexpr MatrixT<n, m, T> operator-(T2 const &value) const
+    requires(std::is_arithmetic<T2>::value && m > 1);
+  template <typename T2>
+  constexpr friend MatrixT<n, m, T> operator+(T2 const &value, MatrixT<n, m, T> const &matrix)
+    requires(std::is_arithmetic<T2>::value && m > 1)
+  {
     return matrix + value;
   }
   inline MatrixT<n, m, T> &operator+=(MatrixT<n, m, T> const &other);
@@ -98,14 +125,31 @@ public:
     requires(std::is_arithmetic<T2>::value);
   inline MatrixT<n, m, T> &operator-=(MatrixT<n, m, T> const &other);
   template <typename T2> inline MatrixT<n, m, T> &operator-=(T2 const &value);
-  template <uint8_t l> inline MatrixT<n, l, T> operator*(MatrixT<m, l, T> const &other) const;
+  template <VectorExpression E>
+  constexpr MatrixT<n, m, T> &operator+=(E const &expression)
+    requires(m == 1 && E::size == n)
+  {
+    [&]<size_t... i>(std::index_sequence<i...>) { ((data[i] += expression[i]), ...); }(std::make_index_sequence<n>{});
+    return *this;
+  }
+  template <VectorExpression E>
+  constexpr MatrixT<n, m, T> &operator-=(E const &expression)
+    requires(m == 1 && E::size == n)
+  {
+    [&]<size_t... i>(std::index_sequence<i...>) { ((data[i] -= expression[i]), ...); }(std::make_index_sequence<n>{});
+    return *this;
+  }
+  template <uint8_t l> constexpr MatrixT<n, l, T> operator*(MatrixT<m, l, T> const &other) const;
   template <typename T2>
-  inline MatrixT<n, m, T> operator*(T2 const &value) const
-    requires(std::is_arithmetic<T2>::value);
+  constexpr MatrixT<n, m, T> operator*(T2 const &value) const
+    requires(std::is_arithmetic<T2>::value && m > 1);
   template <typename T2>
-  inline MatrixT<n, m, T> operator/(T2 const &value) const
-    requires(std::is_arithmetic<T2>::value);
-  template <typename T2> inline friend MatrixT<n, m, T> operator*(T2 const &value, MatrixT<n, m, T> const &matrix) {
+  constexpr MatrixT<n, m, T> operator/(T2 const &value) const
+    requires(std::is_arithmetic<T2>::value && m > 1);
+  template <typename T2>
+  constexpr friend MatrixT<n, m, T> operator*(T2 const &value, MatrixT<n, m, T> const &matrix)
+    requires(std::is_arithmetic<T2>::value && m > 1)
+  {
     return matrix * value;
   }
   inline MatrixT<n, m, T> &operator*=(MatrixT<n, m, T> const &other);
@@ -115,7 +159,7 @@ public:
   template <typename T2>
   inline MatrixT<n, m, T> &operator/=(T2 const &value)
     requires(std::is_arithmetic<T2>::value);
-  inline MatrixT<m, n, T> Transposed() const;
+  constexpr MatrixT<m, n, T> Transposed() const;
   inline MatrixT<n, n, T> Inverse() const
     requires(m == n)
   {
@@ -126,10 +170,10 @@ public:
   inline T maxEntry() const { return *std::max_element(std::begin(data), std::end(data)); }
   inline T minEntry() const { return *std::min_element(std::begin(data), std::end(data)); }
 
-  inline static MatrixT<n, n, T> Identity()
+  constexpr static MatrixT<n, n, T> Identity()
     requires(m == n);
-  inline static MatrixT<n, m, T> Zero();
-  inline static MatrixT<n, m, T> One();
+  constexpr static MatrixT<n, m, T> Zero();
+  constexpr static MatrixT<n, m, T> One();
 
   template <class TokenIterator>
   friend TokenIterator parse_tokenstream(TokenIterator begin, TokenIterator end, MatrixT<n, m, T> &output);
@@ -139,12 +183,23 @@ public:
   // +--------------------------------+
   // |    Vector-specific operations  |
   // +--------------------------------+
-  inline T operator*(VectorT<n, T> const &other) const
+  constexpr T operator*(VectorT<n, T> const &other) const
     requires(m == 1)
   {
-    return (other.Transposed() * *this)[X];
+#ifdef MATHS_SIMD_SSE
+    if constexpr (n == 4 && std::is_same_v<T, float>) {
+      if (!std::is_constant_evaluated()) {
+        return SIMD::Dot4(data.data(), other.data.data());
+      }
+    }
+#endif
+    T result = 0;
+    for (uint8_t i = 0; i < n; i++) {
+      result += other.data[i] * data[i];
+    }
+    return result;
   }
-  inline T SqrMagnitude() const
+  constexpr T SqrMagnitude() const
     requires(m == 1)
   {
     return *this * *this;
@@ -154,12 +209,12 @@ public:
   {
     return std::sqrt(SqrMagnitude());
   }
-  inline T &operator[](uint8_t i)
+  constexpr T &operator[](uint8_t i)
     requires(m == 1)
   {
     return data[i];
   }
-  inline T const &operator[](uint8_t i) const
+  constexpr T const &operator[](uint8_t i) const
     requires(m == 1)
   {
     return data[i];
@@ -174,10 +229,10 @@ public:
   {
     return (*this /= this->Length());
   }
-  inline VectorT<3, T> Cross(VectorT<3, T> const &other) const
+  constexpr VectorT<3, T> Cross(VectorT<3, T> const &other) const
     requires(m == 1 && n == 3);
 
-  inline T Volume() const
+  constexpr T Volume() const
     requires(m == 1);
 
   // "Properties" for easier access
@@ -187,7 +242,7 @@ private:
     uint8_t row;
 
   public:
-    Row(MatrixT<n, m, T> &mat, uint8_t row) : parent(mat), row(row) {}
+    constexpr Row(MatrixT<n, m, T> &mat, uint8_t row) : parent(mat), row(row) {}
     inline VectorT<m, T> operator=(VectorT<m, T> const &values) {
       for (uint8_t col = 0; col < m; col++) {
         parent.data[row * m + col] = values[col];
@@ -201,7 +256,7 @@ private:
       }
     }
 
-    inline T &operator[](uint8_t column) { return parent.data[row * m + column]; }
+    constexpr T &operator[](uint8_t column) { return parent.data[row * m + column]; }
   };
 
   class ConstRow {
@@ -209,7 +264,7 @@ private:
     uint8_t row;
 
   public:
-    ConstRow(MatrixT<n, m, T> const &mat, uint8_t row) : parent(mat), row(row) {}
+    constexpr ConstRow(MatrixT<n, m, T> const &mat, uint8_t row) : parent(mat), row(row) {}
 
     inline operator VectorT<m, T>() const {
       VectorT<m, T> res{};
@@ -219,7 +274,7 @@ private:
       return res;
     }
 
-    inline T const &operator[](uint8_t column) const { return parent.data[row * m + column]; }
+    constexpr T const &operator[](uint8_t column) const { return parent.data[row * m + column]; }
   };
 
   class Entry {
@@ -385,13 +440,13 @@ private:
   };
 
 public:
-  inline Row operator[](uint8_t row) { return Row(*this, row); };
-  inline ConstRow operator[](uint8_t row) const { return ConstRow(*this, row); };
+  constexpr Row operator[](uint8_t row) { return Row(*this, row); };
+  constexpr ConstRow operator[](uint8_t row) const { return ConstRow(*this, row); };
 
   // TODO: Allow value retrieval on const vectors?
-  inline T x() const { return data[X]; }
-  inline T y() const { return data[Y]; }
-  inline T z() const { return data[Z]; }
+  constexpr T x() const { return data[X]; }
+  constexpr T y() const { return data[Y]; }
+  constexpr T z() const { return data[Z]; }
   Entry x()
     requires(m == 1)
   {
@@ -462,6 +517,16 @@ template <uint8_t n, uint8_t m, typename T>
 inline MatrixT<n, n, T> &MatrixT<n, m, T>::Invert() // Uses the gaussean algorithm
   requires(m == n)
 {
+#ifdef MATHS_SIMD_SSE
+  if constexpr (n == 4 && std::is_same_v<T, float>) {
+    alignas(16) std::array<T, n * m> inverse;
+    if (!SIMD::Inverse4x4(data.data(), inverse.data())) {
+      throw "Inverse of irregular matrix requested.";
+    }
+    data = inverse;
+    return *this;
+  }
+#endif
   MatrixT<n, n, T> id = MatrixT<n, n, T>::Identity();
   // Triangularize A
   for (int diag = 0; diag < n; diag++) // Pass along diagonal
@@ -511,32 +576,41 @@ inline MatrixT<n, n, T> &MatrixT<n, m, T>::Invert() // Uses the gaussean algorit
 }
 
 template <uint8_t n, uint8_t m, typename T>
-inline MatrixT<n, n, T> MatrixT<n, m, T>::Identity()
+constexpr MatrixT<n, n, T> MatrixT<n, m, T>::Identity()
   requires(m == n)
 {
   std::array<T, n * m> values = {0};
   for (int diag = 0; diag < n; diag++) {
     values[MATRIX_NM_AT_IJ(diag, diag)] = 1;
   }
-  return MatrixT<n, n, T>(values);
+  return MatrixT<n, n, T>(false, values); // Symmetric, so already in column form
 }
 
-template <uint8_t n, uint8_t m, typename T> inline MatrixT<n, m, T> MatrixT<n, m, T>::Zero() { return {}; }
+template <uint8_t n, uint8_t m, typename T> constexpr MatrixT<n, m, T> MatrixT<n, m, T>::Zero() { return {}; }
 
-template <uint8_t n, uint8_t m, typename T> inline MatrixT<n, m, T> MatrixT<n, m, T>::One() {
+template <uint8_t n, uint8_t m, typename T> constexpr MatrixT<n, m, T> MatrixT<n, m, T>::One() {
   return MatrixT<n, m, T>::Zero() + 1;
 }
 
 template <uint8_t n, uint8_t m, typename T>
-inline VectorT<3, T> MatrixT<n, m, T>::Cross(VectorT<3, T> const &other) const
+constexpr VectorT<3, T> MatrixT<n, m, T>::Cross(VectorT<3, T> const &other) const
   requires(m == 1 && n == 3)
 {
+#ifdef MATHS_SIMD_SSE
+  if constexpr (std::is_same_v<T, float>) {
+    if (!std::is_constant_evaluated()) {
+      VectorT<3, T> result;
+      SIMD::Cross3(data.data(), other.data.data(), result.data.data());
+      return result;
+    }
+  }
+#endif
   return VectorT<3, T>{data[Y] * other[Z] - data[Z] * other[Y], data[Z] * other[X] - data[X] * other[Z],
                        data[X] * other[Y] - data[Y] * other[X]};
 }
 
 template <uint8_t n, uint8_t m, typename T>
-inline T MatrixT<n, m, T>::Volume() const
+constexpr T MatrixT<n, m, T>::Volume() const
   requires(m == 1)
 {
   T res = data[0];
@@ -576,7 +650,20 @@ template <uint8_t n, uint8_t m, typename T> inline void MatrixT<n, m, T>::RowSwa
 
 template <uint8_t n, uint8_t m, typename T>
 template <uint8_t l>
-inline MatrixT<n, l, T> MatrixT<n, m, T>::operator*(MatrixT<m, l, T> const &other) const {
+constexpr MatrixT<n, l, T> MatrixT<n, m, T>::operator*(MatrixT<m, l, T> const &other) const {
+#ifdef MATHS_SIMD_SSE
+  if constexpr (n == 4 && m == 4 && (l == 4 || l == 1) && std::is_same_v<T, float>) {
+    if (!std::is_constant_evaluated()) {
+      MatrixT<n, l, T> result;
+      if constexpr (l == 4) {
+        SIMD::Multiply4x4(data.data(), other.data.data(), result.data.data());
+      } else {
+        SIMD::MultiplyVector4(data.data(), other.data.data(), result.data.data());
+      }
+      return result;
+    }
+  }
+#endif
   std::array<T, n * l> newVals{};
   for (int resCol = 0; resCol < l; resCol++) {
     for (int resRow = 0; resRow < n; resRow++) {
@@ -606,7 +693,9 @@ inline bool MatrixT<n, m, T>::operator==(MatrixT<n, m, T> const &other) const {
 }
 
 template <uint8_t n, uint8_t m, typename T>
-inline MatrixT<n, m, T> MatrixT<n, m, T>::operator+(MatrixT<n, m, T> const &other) const {
+constexpr MatrixT<n, m, T> MatrixT<n, m, T>::operator+(MatrixT<n, m, T> const &other) const
+  requires(m > 1)
+{
   std::array<T, n * m> newVals;
   for (int i = 0; i < n * m; i++) {
     newVals[i] = data[i] + other[i];
@@ -615,7 +704,9 @@ inline MatrixT<n, m, T> MatrixT<n, m, T>::operator+(MatrixT<n, m, T> const &othe
 }
 
 template <uint8_t n, uint8_t m, typename T>
-inline MatrixT<n, m, T> MatrixT<n, m, T>::operator-(MatrixT<n, m, T> const &other) const {
+constexpr MatrixT<n, m, T> MatrixT<n, m, T>::operator-(MatrixT<n, m, T> const &other) const
+  requires(m > 1)
+{
   std::array<T, n * m> newVals;
   for (int i = 0; i < n * m; i++) {
     newVals[i] = data[i] - other[i];
@@ -625,8 +716,8 @@ inline MatrixT<n, m, T> MatrixT<n, m, T>::operator-(MatrixT<n, m, T> const &othe
 
 template <uint8_t n, uint8_t m, typename T>
 template <typename T2>
-inline MatrixT<n, m, T> MatrixT<n, m, T>::operator+(T2 const &value) const
-  requires(std::is_arithmetic<T2>::value)
+constexpr MatrixT<n, m, T> MatrixT<n, m, T>::operator+(T2 const &value) const
+  requires(std::is_arithmetic<T2>::value && m > 1)
 {
   std::array<T, n * m> newVals;
   for (int i = 0; i < n * m; i++) {
@@ -637,8 +728,8 @@ inline MatrixT<n, m, T> MatrixT<n, m, T>::operator+(T2 const &value) const
 
 template <uint8_t n, uint8_t m, typename T>
 template <typename T2>
-inline MatrixT<n, m, T> MatrixT<n, m, T>::operator-(T2 const &value) const
-  requires(std::is_arithmetic<T2>::value)
+constexpr MatrixT<n, m, T> MatrixT<n, m, T>::operator-(T2 const &value) const
+  requires(std::is_arithmetic<T2>::value && m > 1)
 {
   std::array<T, n * m> newVals;
   for (int i = 0; i < n * m; i++) {
@@ -715,8 +806,8 @@ inline MatrixT<n, m, T> &MatrixT<n, m, T>::operator/=(T2 const &value)
 
 template <uint8_t n, uint8_t m, typename T>
 template <typename T2>
-inline MatrixT<n, m, T> MatrixT<n, m, T>::operator*(T2 const &value) const
-  requires(std::is_arithmetic<T2>::value)
+constexpr MatrixT<n, m, T> MatrixT<n, m, T>::operator*(T2 const &value) const
+  requires(std::is_arithmetic<T2>::value && m > 1)
 {
   std::array<T, n * m> newVals;
   for (int i = 0; i < n * m; i++) {
@@ -727,8 +818,8 @@ inline MatrixT<n, m, T> MatrixT<n, m, T>::operator*(T2 const &value) const
 
 template <uint8_t n, uint8_t m, typename T>
 template <typename T2>
-inline MatrixT<n, m, T> MatrixT<n, m, T>::operator/(T2 const &value) const
-  requires(std::is_arithmetic<T2>::value)
+constexpr MatrixT<n, m, T> MatrixT<n, m, T>::operator/(T2 const &value) const
+  requires(std::is_arithmetic<T2>::value && m > 1)
 {
   std::array<T, n * m> newVals;
   for (int i = 0; i < n * m; i++) {
@@ -737,29 +828,35 @@ inline MatrixT<n, m, T> MatrixT<n, m, T>::operator/(T2 const &value) const
   return MatrixT<n, m, T>(newVals);
 }
 
-template <uint8_t n, uint8_t m, typename T> inline MatrixT<m, n, T> MatrixT<n, m, T>::Transposed() const {
+template <uint8_t n, uint8_t m, typename T> constexpr MatrixT<m, n, T> MatrixT<n, m, T>::Transposed() const {
+#ifdef MATHS_SIMD_SSE
+  if constexpr (n == 4 && m == 4 && std::is_same_v<T, float>) {
+    if (!std::is_constant_evaluated()) {
+      MatrixT<m, n, T> result;
+      SIMD::Transpose4x4(data.data(), result.data.data());
+      return result;
+    }
+  }
+#endif
   std::array<T, n * m> newVals;
   for (int row = 0; row < n; row++) {
     for (int col = 0; col < m; col++) {
       newVals[MATRIX_AT_IJ(m, n, col, row)] = data[MATRIX_AT_IJ(n, m, row, col)];
     }
   }
-  return MatrixT<m, n, T>(newVals);
+  return MatrixT<m, n, T>(false, newVals); // Already in column form
 }
 
-template <uint8_t n, uint8_t m, typename T> inline void MatrixT<n, m, T>::ConvertToColumnForm() {
-  std::array<T, n * m> transposedData;
-  for (int row = 0; row < n; row++) {
-    for (int col = 0; col < m; col++) {
-      transposedData[MATRIX_AT_IJ(n, m, row, col)] =
-          data[MATRIX_AT_IJ(m, n, col, row)]; // values are row-wise but data is column-wise
-    }
+template <uint8_t n, uint8_t m, typename T> constexpr void MatrixT<n, m, T>::ConvertToColumnForm() {
+  if constexpr (n > 1 && m > 1) { // Row and column form are the same for vectors
+    data = ToColumnForm(data, std::make_index_sequence<n * m>{}); // values are row-wise but data is column-wise
   }
-  data = transposedData;
 }
 
 } // namespace Engine::Maths
 
+#include "VectorExpression.h"
+
 #include <format>
 #include <functional>
 #include <sstream>
@@ -814,4 +911,4 @@ template <uint8_t n, typename T> struct formatter<Engine::Maths::VectorT<n, T>>
 } // namespace std
 
 TEMPLATED_JSON(TEMPLATE_ARGS(uint8_t n, uint8_t m, typename T), Engine::Maths::MatrixT<TEMPLATE_ARGS(n, m, T)>,
-               FIELDS(data));
\ No newline at end of file
+               FIELDS(data));
\ No newline at end of file
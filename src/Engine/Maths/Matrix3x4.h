@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Matrix.h"
+#include "Quaternion.h"
+
+namespace Engine::Maths {
+// Affine transform, i.e. a 4x4 matrix whose last row is (0, 0, 0, 1), which is all that model matrices need. Only the
+// linear part L and the translation t are saved, in column form like MatrixT (the columns of L, then t). That takes a
+// quarter less memory than Matrix4 and lets composing and inverting skip the constant row.
+struct alignas(16) Matrix3x4 {
+  std::array<float, 12> data;
+
+  Matrix3x4() : data() {}
+  Matrix3x4(Vector3 const &x, Vector3 const &y, Vector3 const &z, Vector3 const &translation)
+      : data{x[X], x[Y], x[Z], y[X], y[Y], y[Z], z[X], z[Y], z[Z], translation[X], translation[Y], translation[Z]} {}
+
+  inline static Matrix3x4 Identity() { return Matrix3x4({1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0, 0, 0}); }
+  // Translation * rotation * scale
+  inline static Matrix3x4 FromTRS(Vector3 const &position, Quaternion const &rotation, Vector3 const &scale);
+
+  inline float operator()(uint8_t row, uint8_t col) const { return data[col * 3 + row]; }
+  inline float &operator()(uint8_t row, uint8_t col) { return data[col * 3 + row]; }
+  inline Vector3 Column(uint8_t col) const { return {data[col * 3], data[col * 3 + 1], data[col * 3 + 2]}; }
+  inline Vector3 Translation() const { return Column(3); }
+  inline Matrix3 Linear() const;
+
+  inline Matrix3x4 operator*(Matrix3x4 const &other) const;
+  inline Matrix3x4 &operator*=(Matrix3x4 const &other) { return *this = *this * other; }
+  inline bool operator==(Matrix3x4 const &other) const { return data == other.data; }
+  inline Vector3 TransformPoint(Vector3 const &point) const { return TransformDirection(point) + Translation(); }
+  inline Vector3 TransformDirection(Vector3 const &direction) const;
+
+  inline float Determinant() const { return Column(0) * Column(1).Cross(Column(2)); }
+  // Closed form through the cross products of the columns. Singular matrices give non-finite entries.
+  inline Matrix3x4 Inverse() const;
+  // Inverse of a matrix without shear (orthogonal columns), as built by FromTRS: the rotation is transposed and the
+  // scale inverted
+  inline Matrix3x4 InverseTRS() const;
+  // Inverse-transpose of the linear part, which transforms normals
+  inline Matrix3 NormalMatrix() const;
+  // Like NormalMatrix, for matrices without shear: the rotation scaled by the reciprocal scale
+  inline Matrix3 NormalMatrixTRS() const;
+
+  inline Matrix4 ToMatrix4() const;
+};
+
+inline Matrix3x4 Matrix3x4::FromTRS(Vector3 const &position, Quaternion const &rotation, Vector3 const &scale) {
+  // The rows of RotationMatrix are the columns of the rotation
+  float w = rotation.w, x = rotation.x, y = rotation.y, z = rotation.z;
+  Matrix3x4 result;
+  result.data = {scale[X] * (w * w + x * x - y * y - z * z),
+                 scale[X] * 2 * (x * y + w * z),
+                 scale[X] * 2 * (x * z - w * y),
+
+                 scale[Y] * 2 * (x * y - w * z),
+                 scale[Y] * (w * w - x * x + y * y - z * z),
+                 scale[Y] * 2 * (w * x + y * z),
+
+                 scale[Z] * 2 * (w * y + x * z),
+                 scale[Z] * 2 * (y * z - w * x),
+                 scale[Z] * (w * w - x * x - y * y + z * z),
+
+                 position[X],
+                 position[Y],
+                 position[Z]};
+  return result;
+}
+
+inline Matrix3 Matrix3x4::Linear() const {
+  return Matrix3{data[0], data[3], data[6], data[1], data[4], data[7], data[2], data[5], data[8]};
+}
+
+inline Matrix3x4 Matrix3x4::operator*(Matrix3x4 const &other) const {
+  Matrix3x4 result;
+  float const *a = data.data(), *b = other.data.data();
+  for (int col = 0; col < 4; col++) {
+    float const *c = b + col * 3;
+    for (int row = 0; row < 3; row++) {
+      result.data[col * 3 + row] = a[row] * c[0] + a[3 + row] * c[1] + a[6 + row] * c[2] + (col == 3 ? a[9 + row] : 0);
+    }
+  }
+  return result;
+}
+
+inline Vector3 Matrix3x4::TransformDirection(Vector3 const &direction) const {
+  return {data[0] * direction[X] + data[3] * direction[Y] + data[6] * direction[Z],
+          data[1] * direction[X] + data[4] * direction[Y] + data[7] * direction[Z],
+          data[2] * direction[X] + data[5] * direction[Y] + data[8] * direction[Z]};
+}
+
+// The rows of the inverse of L are the cross products of its columns divided by the determinant, so the rows of the
+// normal matrix are the same cross products. Written out on plain floats, as this runs once per transform and frame.
+inline Matrix3x4 Matrix3x4::Inverse() const {
+  float const *a = data.data(), *b = a + 3, *c = a + 6, *t = a + 9;
+  float rows[3][3] = {{b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0]},
+                      {c[1] * a[2] - c[2] * a[1], c[2] * a[0] - c[0] * a[2], c[0] * a[1] - c[1] * a[0]},
+                      {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]}};
+  float inverseDeterminant = 1.0f / (a[0] * rows[0][0] + a[1] * rows[0][1] + a[2] * rows[0][2]);
+  Matrix3x4 result;
+  for (int row = 0; row < 3; row++) {
+    for (int col = 0; col < 3; col++) {
+      result.data[col * 3 + row] = rows[row][col] * inverseDeterminant;
+    }
+    result.data[9 + row] = -(rows[row][0] * t[0] + rows[row][1] * t[1] + rows[row][2] * t[2]) * inverseDeterminant;
+  }
+  return result;
+}
+
+// Column j of L is the rotated axis times s_j, so row j of the inverse is the same column divided by s_j^2
+inline Matrix3x4 Matrix3x4::InverseTRS() const {
+  float const *t = data.data() + 9;
+  Matrix3x4 result;
+  for (int row = 0; row < 3; row++) {
+    float const *axis = data.data() + row * 3;
+    float inverseSqrScale = 1.0f / (axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    for (int col = 0; col < 3; col++) {
+      result.data[col * 3 + row] = axis[col] * inverseSqrScale;
+    }
+    result.data[9 + row] = -(axis[0] * t[0] + axis[1] * t[1] + axis[2] * t[2]) * inverseSqrScale;
+  }
+  return result;
+}
+
+inline Matrix3 Matrix3x4::NormalMatrix() const {
+  Matrix3x4 inverse = Inverse();
+  return Matrix3{inverse.data[0], inverse.data[1], inverse.data[2], inverse.data[3], inverse.data[4],
+                 inverse.data[5], inverse.data[6], inverse.data[7], inverse.data[8]};
+}
+
+inline Matrix3 Matrix3x4::NormalMatrixTRS() const {
+  Matrix3x4 inverse = InverseTRS();
+  return Matrix3{inverse.data[0], inverse.data[1], inverse.data[2], inverse.data[3], inverse.data[4],
+                 inverse.data[5], inverse.data[6], inverse.data[7], inverse.data[8]};
+}
+
+inline Matrix4 Matrix3x4::ToMatrix4() const {
+  return Matrix4{data[0], data[3], data[6], data[9],  //
+                 data[1], data[4], data[7], data[10], //
+                 data[2], data[5], data[8], data[11], //
+                 0,       0,       0,       1};
+}
+
+} // namespace Engine::Maths
@@ -3,12 +3,14 @@
 #include "Matrix.h"
 #include "json-parsing.h"
 
+#define QUATERNION_SLERP_THRESHOLD 0.9995f // Cosine above which Slerp uses Nlerp, as sin(theta) gets too small
+
 namespace Engine::Maths {
 class Quaternion {
 public:
   float w, x, y, z;
   Quaternion(float w, float x, float y, float z) : w(w), x(x), y(y), z(z) {}
-  Quaternion(Quaternion const &other) : w(other.w), x(other.x), y(other.y), z(other.z) {}
+  Quaternion(Quaternion const &other) = default;
   Quaternion(Vector3 const &p) : w(0), x(p[X]), y(p[Y]), z(p[Z]) {}          // For rotating p (by calculating r p r*)
   Quaternion(float w, Vector3 const &p) : w(w), x(p[X]), y(p[Y]), z(p[Z]) {} // For rotating p (by calculating r p r*)
   Quaternion() : w(0), x(0), y(0), z(0) {}
@@ -21,9 +23,15 @@ public:
   }
 
   inline Quaternion Conjugate() const { return {w, -x, -y, -z}; }
-  inline Quaternion Normalized() const { return Quaternion(*this) / Vector4{w, x, y, z}.SqrMagnitude(); }
+  inline float Dot(Quaternion const &other) const { return w * other.w + x * other.x + y * other.y + z * other.z; }
+  inline float Length() const { return std::sqrt(Dot(*this)); }
+  inline Quaternion Normalized() const { return Quaternion(*this) / Length(); }
   inline Quaternion &Normalize();
 
+  // Interpolate along the shorter arc between two rotations. Nlerp is cheaper, but does not turn at constant speed.
+  inline static Quaternion Nlerp(Quaternion const &a, Quaternion const &b, float t);
+  inline static Quaternion Slerp(Quaternion const &a, Quaternion const &b, float t);
+
   inline Quaternion operator*(float theta) const { return {w * theta, x * theta, y * theta, z * theta}; }
   inline Quaternion operator/(float theta) const { return {w / theta, x / theta, y / theta, z / theta}; }
   inline friend Quaternion operator*(float theta, Quaternion const &q) { return q * theta; }
@@ -74,11 +82,26 @@ Quaternion Quaternion::operator*(Quaternion const &other) const {
 }
 
 Quaternion &Quaternion::Normalize() {
-  float sqrLen = Vector4{w, x, y, z}.SqrMagnitude();
-  *this /= sqrLen;
+  *this /= Length();
   return *this;
 }
 
+inline Quaternion Quaternion::Nlerp(Quaternion const &a, Quaternion const &b, float t) {
+  float tb = a.Dot(b) < 0 ? -t : t; // q and -q are the same rotation
+  return (a * (1 - t) + b * tb).Normalized();
+}
+
+inline Quaternion Quaternion::Slerp(Quaternion const &a, Quaternion const &b, float t) {
+  float cosTheta = a.Dot(b);
+  float sign = cosTheta < 0 ? -1.0f : 1.0f;
+  cosTheta *= sign;
+  if (cosTheta > QUATERNION_SLERP_THRESHOLD) {
+    return Nlerp(a, b, t);
+  }
+  float theta = std::acos(cosTheta), sinTheta = std::sin(theta);
+  return a * (std::sin((1 - t) * theta) / sinTheta) + b * (sign * std::sin(t * theta) / sinTheta);
+}
+
 inline Quaternion &Quaternion::operator*=(Quaternion const &other) {
   *this = *this * other;
   return *this;
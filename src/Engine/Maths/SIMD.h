@@ -0,0 +1,149 @@
+#pragma once
+
+// SSE (and, where the compiler targets it, AVX2) kernels for the 16 byte aligned 4x4 float matrices and vectors of
+// Matrix.h. They are selected at compile time: MATHS_SIMD is defined by the build (BUILD_WITH_SIMD), AVX2 is used on
+// top of SSE when building with /arch:AVX2 or -mavx2 (BUILD_WITH_AVX2). Without them, MatrixT uses its scalar loops,
+// which stay the reference implementation. Matrices are in column form, so every __m128 holds one column.
+#if defined(MATHS_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATHS_SIMD_SSE
+#if defined(__AVX2__)
+#define MATHS_SIMD_AVX2
+#endif
+#endif
+
+#ifdef MATHS_SIMD_SSE
+#include <immintrin.h>
+
+#define SIMD_SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define SIMD_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, SIMD_SHUFFLE_MASK(x, y, z, w))
+#define SIMD_SHUFFLE(v1, v2, x, y, z, w) _mm_shuffle_ps(v1, v2, SIMD_SHUFFLE_MASK(x, y, z, w))
+
+namespace Engine::Maths::SIMD {
+
+// column * (x, x, x, x) + ... for the four columns of a
+inline __m128 Combine(float const *a, __m128 v) {
+  __m128 result = _mm_mul_ps(_mm_load_ps(a), SIMD_SWIZZLE(v, 0, 0, 0, 0));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(a + 4), SIMD_SWIZZLE(v, 1, 1, 1, 1)));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(a + 8), SIMD_SWIZZLE(v, 2, 2, 2, 2)));
+  return _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(a + 12), SIMD_SWIZZLE(v, 3, 3, 3, 3)));
+}
+
+inline void Multiply4x4(float const *a, float const *b, float *result) {
+#ifdef MATHS_SIMD_AVX2
+  // Two columns of the result at once, each lane holds the same columns of a
+  __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(a));
+  __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(a + 4));
+  __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(a + 8));
+  __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(a + 12));
+  for (int col = 0; col < 4; col += 2) {
+    __m256 b01 = _mm256_loadu_ps(b + col * 4); // Matrix4 is only 16 byte aligned
+    __m256 sum = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, SIMD_SHUFFLE_MASK(0, 0, 0, 0)));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, SIMD_SHUFFLE_MASK(1, 1, 1, 1))));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, SIMD_SHUFFLE_MASK(2, 2, 2, 2))));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, SIMD_SHUFFLE_MASK(3, 3, 3, 3))));
+    _mm256_storeu_ps(result + col * 4, sum);
+  }
+#else
+  for (int col = 0; col < 4; col++) {
+    _mm_store_ps(result + col * 4, Combine(a, _mm_load_ps(b + col * 4)));
+  }
+#endif
+}
+
+inline void MultiplyVector4(float const *a, float const *v, float *result) {
+  _mm_store_ps(result, Combine(a, _mm_load_ps(v)));
+}
+
+inline void Transpose4x4(float const *a, float *result) {
+  __m128 c0 = _mm_load_ps(a), c1 = _mm_load_ps(a + 4), c2 = _mm_load_ps(a + 8), c3 = _mm_load_ps(a + 12);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+  _mm_store_ps(result, c0);
+  _mm_store_ps(result + 4, c1);
+  _mm_store_ps(result + 8, c2);
+  _mm_store_ps(result + 12, c3);
+}
+
+// 2x2 matrices are packed as (m00, m01, m10, m11). Products with adjugates (#) keep the block inverse division-free.
+inline __m128 Mat2Mul(__m128 a, __m128 b) {
+  return _mm_add_ps(_mm_mul_ps(a, SIMD_SWIZZLE(b, 0, 3, 0, 3)),
+                    _mm_mul_ps(SIMD_SWIZZLE(a, 1, 0, 3, 2), SIMD_SWIZZLE(b, 2, 1, 2, 1)));
+}
+// a# * b
+inline __m128 Mat2AdjMul(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(SIMD_SWIZZLE(a, 3, 3, 0, 0), b),
+                    _mm_mul_ps(SIMD_SWIZZLE(a, 1, 1, 2, 2), SIMD_SWIZZLE(b, 2, 3, 0, 1)));
+}
+// a * b#
+inline __m128 Mat2MulAdj(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(a, SIMD_SWIZZLE(b, 3, 0, 3, 0)),
+                    _mm_mul_ps(SIMD_SWIZZLE(a, 1, 0, 3, 2), SIMD_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// Block-wise inverse through the 2x2 sub-matrices
+//   M = | A B |   M^-1 = 1/|M| | X# Y# |
+//       | C D |                | Z# W# |
+// Works on the transpose just the same, so it does not matter that the columns are loaded as rows. Returns false for
+// singular matrices.
+inline bool Inverse4x4(float const *m, float *result) {
+  __m128 r0 = _mm_load_ps(m), r1 = _mm_load_ps(m + 4), r2 = _mm_load_ps(m + 8), r3 = _mm_load_ps(m + 12);
+  __m128 A = _mm_movelh_ps(r0, r1), B = _mm_movehl_ps(r1, r0);
+  __m128 C = _mm_movelh_ps(r2, r3), D = _mm_movehl_ps(r3, r2);
+
+  // (|A|, |B|, |C|, |D|)
+  __m128 detSub = _mm_sub_ps(_mm_mul_ps(SIMD_SHUFFLE(r0, r2, 0, 2, 0, 2), SIMD_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+                             _mm_mul_ps(SIMD_SHUFFLE(r0, r2, 1, 3, 1, 3), SIMD_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+  __m128 detA = SIMD_SWIZZLE(detSub, 0, 0, 0, 0), detB = SIMD_SWIZZLE(detSub, 1, 1, 1, 1);
+  __m128 detC = SIMD_SWIZZLE(detSub, 2, 2, 2, 2), detD = SIMD_SWIZZLE(detSub, 3, 3, 3, 3);
+
+  __m128 D_C = Mat2AdjMul(D, C);
+  __m128 A_B = Mat2AdjMul(A, B);
+  __m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+  __m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+  __m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+  __m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+  // |M| = |A| |D| + |B| |C| - tr((A# B) (D# C))
+  __m128 trace = _mm_mul_ps(A_B, SIMD_SWIZZLE(D_C, 0, 2, 1, 3));
+  trace = _mm_add_ps(trace, SIMD_SWIZZLE(trace, 1, 0, 3, 2));
+  trace = _mm_add_ps(trace, SIMD_SWIZZLE(trace, 2, 3, 0, 1));
+  __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+  if (_mm_cvtss_f32(detM) == 0) {
+    return false;
+  }
+
+  __m128 inverseDetM = _mm_div_ps(_mm_setr_ps(1, -1, -1, 1), detM);
+  X_ = _mm_mul_ps(X_, inverseDetM);
+  Y_ = _mm_mul_ps(Y_, inverseDetM);
+  Z_ = _mm_mul_ps(Z_, inverseDetM);
+  W_ = _mm_mul_ps(W_, inverseDetM);
+
+  // Taking the adjugates and unpacking the blocks in one shuffle
+  _mm_store_ps(result, SIMD_SHUFFLE(X_, Y_, 3, 1, 3, 1));
+  _mm_store_ps(result + 4, SIMD_SHUFFLE(X_, Y_, 2, 0, 2, 0));
+  _mm_store_ps(result + 8, SIMD_SHUFFLE(Z_, W_, 3, 1, 3, 1));
+  _mm_store_ps(result + 12, SIMD_SHUFFLE(Z_, W_, 2, 0, 2, 0));
+  return true;
+}
+
+inline float Dot4(float const *a, float const *b) {
+  __m128 product = _mm_mul_ps(_mm_load_ps(a), _mm_load_ps(b));
+  product = _mm_add_ps(product, SIMD_SWIZZLE(product, 1, 0, 3, 2));
+  product = _mm_add_ps(product, SIMD_SWIZZLE(product, 2, 3, 0, 1));
+  return _mm_cvtss_f32(product);
+}
+
+// Vector3 is padded to 16 bytes, but the padding is not initialised, so the w lanes are set to zero
+inline void Cross3(float const *a, float const *b, float *result) {
+  __m128 u = _mm_setr_ps(a[0], a[1], a[2], 0), v = _mm_setr_ps(b[0], b[1], b[2], 0);
+  __m128 cross = _mm_sub_ps(_mm_mul_ps(u, SIMD_SWIZZLE(v, 1, 2, 0, 3)), _mm_mul_ps(SIMD_SWIZZLE(u, 1, 2, 0, 3), v));
+  cross = SIMD_SWIZZLE(cross, 1, 2, 0, 3);
+  alignas(16) float values[4];
+  _mm_store_ps(values, cross);
+  result[0] = values[0];
+  result[1] = values[1];
+  result[2] = values[2];
+}
+
+} // namespace Engine::Maths::SIMD
+
+#endif
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <functional>
+
+#include "Matrix.h"
+
+// Element-wise vector arithmetic (+ and - of vectors, + - * / with scalars) is evaluated lazily: the operators return
+// small expression nodes, and a whole chain like a + b * s - c is evaluated in one loop once it is assigned to a
+// vector, without intermediate vectors. Nodes reference named vectors and copy temporaries and other nodes, so they
+// may be kept with auto as long as the named vectors live. They read those vectors when evaluated, not before.
+namespace Engine::Maths {
+
+template <typename V> inline constexpr bool IsVector = false;
+template <uint8_t n, typename T> inline constexpr bool IsVector<MatrixT<n, 1, T>> = true;
+
+template <typename V>
+concept VectorOperand = IsVector<std::remove_cvref_t<V>> || VectorExpression<V>;
+
+template <typename V> struct VectorTraits {
+  static constexpr uint8_t size = V::size;
+  using Type = typename V::Type;
+};
+template <uint8_t n, typename T> struct VectorTraits<MatrixT<n, 1, T>> {
+  static constexpr uint8_t size = n;
+  using Type = T;
+};
+
+template <typename A, typename B>
+concept SameVectorShape = VectorTraits<std::remove_cvref_t<A>>::size == VectorTraits<std::remove_cvref_t<B>>::size &&
+                          std::is_same_v<typename VectorTraits<std::remove_cvref_t<A>>::Type,
+                                         typename VectorTraits<std::remove_cvref_t<B>>::Type>;
+
+// Named vectors are referenced, temporaries and nodes are copied
+template <typename V>
+using StoredOperand = std::conditional_t<std::is_lvalue_reference_v<V> && IsVector<std::remove_cvref_t<V>>,
+                                         std::remove_cvref_t<V> const &, std::remove_cvref_t<V>>;
+
+// A scalar used for every element
+template <typename S> struct ScalarOperand {
+  S value;
+
+  constexpr S operator[](uint8_t) const { return value; }
+};
+
+template <typename V> inline constexpr bool IsScalarOperand = false;
+template <typename S> inline constexpr bool IsScalarOperand<ScalarOperand<S>> = true;
+
+template <typename Op, typename L, typename R> struct VectorExpressionNode {
+  using IsVectorExpression = void;
+  using Traits = VectorTraits<std::remove_cvref_t<std::conditional_t<IsScalarOperand<L>, R, L>>>;
+  static constexpr uint8_t size = Traits::size;
+  using Type = typename Traits::Type;
+
+  L left;
+  R right;
+
+  // Rounded to the vector type after every operation, like the eager operators did
+  constexpr Type operator[](uint8_t i) const { return static_cast<Type>(Op{}(left[i], right[i])); }
+  constexpr VectorT<size, Type> Evaluate() const { return *this; }
+
+  // Other vector operations work on the evaluated vector
+  constexpr Type SqrMagnitude() const { return Evaluate().SqrMagnitude(); }
+  inline Type Length() const { return Evaluate().Length(); }
+  inline VectorT<size, Type> Normalized() const { return Evaluate().Normalized(); }
+  constexpr VectorT<3, Type> Cross(VectorT<3, Type> const &other) const
+    requires(size == 3)
+  {
+    return Evaluate().Cross(other);
+  }
+};
+
+template <typename Op, typename A, typename B> constexpr auto MakeVectorExpression(A &&a, B &&b) {
+  return VectorExpressionNode<Op, StoredOperand<A>, StoredOperand<B>>{std::forward<A>(a), std::forward<B>(b)};
+}
+template <typename Op, typename A, typename S> constexpr auto MakeScalarExpression(A &&a, S value) {
+  return VectorExpressionNode<Op, StoredOperand<A>, ScalarOperand<S>>{std::forward<A>(a), {value}};
+}
+
+template <VectorOperand A, VectorOperand B>
+  requires SameVectorShape<A, B>
+constexpr auto operator+(A &&a, B &&b) {
+  return MakeVectorExpression<std::plus<>>(std::forward<A>(a), std::forward<B>(b));
+}
+template <VectorOperand A, VectorOperand B>
+  requires SameVectorShape<A, B>
+constexpr auto operator-(A &&a, B &&b) {
+  return MakeVectorExpression<std::minus<>>(std::forward<A>(a), std::forward<B>(b));
+}
+
+template <VectorOperand A, typename S>
+  requires std::is_arithmetic_v<S>
+constexpr auto operator+(A &&a, S value) {
+  return MakeScalarExpression<std::plus<>>(std::forward<A>(a), value);
+}
+template <VectorOperand A, typename S>
+  requires std::is_arithmetic_v<S>
+constexpr auto operator+(S value, A &&a) {
+  return MakeScalarExpression<std::plus<>>(std::forward<A>(a), value);
+}
+template <VectorOperand A, typename S>
+  requires std::is_arithmetic_v<S>
+constexpr auto operator-(A &&a, S value) {
+  return MakeScalarExpression<std::minus<>>(std::forward<A>(a), value);
+}
+template <VectorOperand A, typename S>
+  requires std::is_arithmetic_v<S>
+constexpr auto operator*(A &&a, S value) {
+  return MakeScalarExpression<std::multiplies<>>(std::forward<A>(a), value);
+}
+template <VectorOperand A, typename S>
+  requires std::is_arithmetic_v<S>
+constexpr auto operator*(S value, A &&a) {
+  return MakeScalarExpression<std::multiplies<>>(std::forward<A>(a), value);
+}
+template <VectorOperand A, typename S>
+  requires std::is_arithmetic_v<S>
+constexpr auto operator/(A &&a, S value) {
+  return MakeScalarExpression<std::divides<>>(std::forward<A>(a), value);
+}
+
+// Products that need whole vectors evaluate their expression operands first
+template <VectorOperand A, VectorOperand B>
+  requires(SameVectorShape<A, B> && (VectorExpression<A> || VectorExpression<B>))
+constexpr auto operator*(A const &a, B const &b) {
+  using Traits = VectorTraits<std::remove_cvref_t<A>>;
+  return VectorT<Traits::size, typename Traits::Type>(a) * VectorT<Traits::size, typename Traits::Type>(b);
+}
+template <uint8_t n, uint8_t m, typename T, VectorExpression E>
+  requires(E::size == m && std::is_same_v<typename E::Type, T>)
+constexpr MatrixT<n, 1, T> operator*(MatrixT<n, m, T> const &matrix, E const &expression) {
+  return matrix * VectorT<m, T>(expression);
+}
+
+} // namespace Engine::Maths
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Engine/Debug/Logging.h"
+#include "Engine/Util/Macros.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BEGIN_BENCHMARK(label)                                                                                         \
+  void run_##label##_benchmarks(Engine::Test::BenchmarkEnv &env) {                                                     \
+    env.BeginSuite(#label);
+
+#define END_BENCHMARK() }
+
+#define RUN_BENCHMARK(label) run_##label##_benchmarks(env);
+
+namespace Engine::Test {
+
+// Keeps the compiler from optimising away the computation of value (and, for pointers, writes to what they point to)
+template <typename T> inline void DoNotOptimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static void const *volatile escaped;
+  escaped = &value;
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+struct BenchmarkResult {
+  std::string suite;
+  std::string name;
+  size_t items; // Operations per run
+  size_t runs;
+  double minNs, meanNs, medianNs, p90Ns, p99Ns, maxNs;
+
+  inline double NsPerItem() const { return medianNs / items; }
+};
+
+// Times every measurement over a number of runs after some untimed warm-up runs and reports percentiles of the run
+// times, as single runs are easily disturbed by the scheduler. Results can be written to JSON for comparisons.
+class BenchmarkEnv {
+  std::string suite;
+  std::string filter; // Only measurements whose "suite/name" contains the filter are run
+  size_t warmupRuns;
+  size_t runs;
+  std::vector<BenchmarkResult> results;
+
+  // Nearest-rank percentile of sorted values
+  static inline double Percentile(std::vector<double> const &sorted, double percentile) {
+    size_t rank = size_t(std::ceil(percentile * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+  }
+
+public:
+  BenchmarkEnv(size_t warmupRuns = 3, size_t runs = 30, std::string filter = "")
+      : suite(), filter(filter), warmupRuns(warmupRuns), runs(std::max<size_t>(runs, 1)), results() {
+#ifndef NDEBUG
+    Debug::Logging::PrintWarning("Benchmark", "Assertions are enabled, timings are not representative!");
+#endif
+  }
+
+  inline void BeginSuite(const char *label) {
+    suite = label;
+    Debug::Logging::PrintMessage("Benchmark", "Running {} benchmarks...", label);
+  }
+
+  // setup is called before every run and not timed. run has to perform items operations.
+  template <typename Setup, typename Run>
+  void Measure(std::string const &name, size_t items, Setup const &setup, Run const &run) {
+    if (!filter.empty() && (suite + "/" + name).find(filter) == std::string::npos) {
+      return;
+    }
+
+    std::vector<double> durations{};
+    durations.reserve(runs);
+    for (size_t i = 0; i < warmupRuns + runs; i++) {
+      setup();
+      auto start = std::chrono::steady_clock::now();
+      run();
+      auto end = std::chrono::steady_clock::now();
+      if (i >= warmupRuns) {
+        durations.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+      }
+    }
+    std::sort(durations.begin(), durations.end());
+
+    double total = 0;
+    for (double duration : durations) {
+      total += duration;
+    }
+    BenchmarkResult &result = results.emplace_back(BenchmarkResult{
+        .suite = suite,
+        .name = name,
+        .items = std::max<size_t>(items, 1),
+        .runs = runs,
+        .minNs = durations.front(),
+        .meanNs = total / runs,
+        .medianNs = Percentile(durations, 0.5),
+        .p90Ns = Percentile(durations, 0.9),
+        .p99Ns = Percentile(durations, 0.99),
+        .maxNs = durations.back(),
+    });
+    double perItem = result.NsPerItem();
+    Debug::Logging::PrintMessage("Benchmark", "{:<32} median {:>12.0f} ns  p90 {:>12.0f} ns  {:>10.2f} ns/item", name,
+                                 result.medianNs, result.p90Ns, perItem);
+  }
+  template <typename Run> inline void Measure(std::string const &name, size_t items, Run const &run) {
+    Measure(name, items, [] {}, run);
+  }
+
+  inline std::vector<BenchmarkResult> const &Results() const { return results; }
+
+  inline bool WriteJson(std::string const &path) const {
+    std::ofstream file(path);
+    if (!file) {
+      Debug::Logging::PrintError("Benchmark", "Could not open {}!", path);
+      return false;
+    }
+#ifdef NDEBUG
+    const char *build = "release";
+#else
+    const char *build = "debug";
+#endif
+    file << "{\n  \"build\": \"" << build << "\",\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+         << ",\n  \"warmup_runs\": " << warmupRuns << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+      BenchmarkResult const &result = results[i];
+      file << (i ? ",\n" : "\n") << "    {\"suite\": \"" << result.suite << "\", \"name\": \"" << result.name
+           << "\", \"items\": " << result.items << ", \"runs\": " << result.runs << ", \"min_ns\": " << result.minNs
+           << ", \"mean_ns\": " << result.meanNs << ", \"median_ns\": " << result.medianNs
+           << ", \"p90_ns\": " << result.p90Ns << ", \"p99_ns\": " << result.p99Ns << ", \"max_ns\": " << result.maxNs
+           << ", \"ns_per_item\": " << result.NsPerItem() << "}";
+    }
+    file << "\n  ]\n}\n";
+    return bool(file);
+  }
+};
+
+} // namespace Engine::Test
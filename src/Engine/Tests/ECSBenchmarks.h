@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include "Core/ECS.h"
+
+#include <format>
+#include <memory>
+
+using namespace Engine::Core;
+
+namespace Engine::Test {
+
+struct BenchPosition : public ComponentT<BenchPosition> {
+  float x = 0, y = 0, z = 0;
+  BenchPosition(Entity entity) : ComponentT<BenchPosition>(entity) {}
+  inline void CopyFrom(BenchPosition const &other) override {
+    x = other.x;
+    y = other.y;
+    z = other.z;
+  }
+  inline void Serialize(SnapshotWriter &writer) const { writer.Write(x, y, z); }
+  inline void Deserialize(SnapshotReader &reader) { reader.Read(x, y, z); }
+};
+
+struct BenchVelocity : public ComponentT<BenchVelocity> {
+  float x = 1, y = 1, z = 1;
+  BenchVelocity(Entity entity) : ComponentT<BenchVelocity>(entity) {}
+  inline void CopyFrom(BenchVelocity const &other) override {
+    x = other.x;
+    y = other.y;
+    z = other.z;
+  }
+  inline void Serialize(SnapshotWriter &writer) const { writer.Write(x, y, z); }
+  inline void Deserialize(SnapshotReader &reader) { reader.Read(x, y, z); }
+};
+
+inline constexpr uint32_t BENCHMARK_ENTITY_COUNTS[] = {1 << 10, 1 << 12, 1 << 14, 1 << 16};
+
+// Every entity gets a position, every second one a velocity
+inline void PopulateBenchmarkECS(ECS *ecs, uint32_t count, std::vector<EntityId> *entities = nullptr) {
+  for (uint32_t i = 0; i < count; i++) {
+    EntityId e = ecs->_CreateEntity();
+    ecs->AddComponent<BenchPosition>(e);
+    if (i % 2) {
+      ecs->AddComponent<BenchVelocity>(e);
+    }
+    if (entities) {
+      entities->push_back(e);
+    }
+  }
+}
+
+inline std::unique_ptr<ECS> MakeBenchmarkECS(uint32_t count, std::vector<EntityId> *entities = nullptr) {
+  auto ecs = std::make_unique<ECS>();
+  PopulateBenchmarkECS(ecs.get(), count, entities);
+  return ecs;
+}
+
+BEGIN_BENCHMARK(ecs_entities)
+
+ECS::RegisterComponent<BenchPosition>();
+ECS::RegisterComponent<BenchVelocity>();
+
+for (uint32_t count : BENCHMARK_ENTITY_COUNTS) {
+  std::unique_ptr<ECS> ecs;
+  std::vector<EntityId> entities;
+  auto reset = [&]() { ecs = std::make_unique<ECS>(); };
+  auto populate = [&]() {
+    entities.clear();
+    ecs = MakeBenchmarkECS(count, &entities);
+  };
+
+  env.Measure(std::format("create {}", count), count, reset, [&]() { PopulateBenchmarkECS(ecs.get(), count); });
+  env.Measure(std::format("create_bulk {}", count), count, reset, [&]() {
+    std::vector<EntityId> created = ecs->CreateEntities(count);
+    ecs->AddComponents<BenchPosition, BenchVelocity>(created);
+  });
+  env.Measure(std::format("destroy {}", count), count, populate, [&]() {
+    for (EntityId e : entities) {
+      ecs->DestroyEntity(e);
+    }
+  });
+}
+
+END_BENCHMARK() // ecs_entities
+
+BEGIN_BENCHMARK(ecs_access)
+
+ECS::RegisterComponent<BenchPosition>();
+ECS::RegisterComponent<BenchVelocity>();
+
+for (uint32_t count : BENCHMARK_ENTITY_COUNTS) {
+  std::vector<EntityId> entities;
+  std::unique_ptr<ECS> ecs = MakeBenchmarkECS(count, &entities);
+
+  env.Measure(std::format("get_component {}", count), count, [&]() {
+    float sum = 0;
+    for (EntityId e : entities) {
+      sum += ecs->GetComponent<BenchPosition>(e)->x;
+    }
+    DoNotOptimize(sum);
+  });
+  env.Measure(std::format("filter {}", count), count, [&]() {
+    auto matches = ecs->FilterEntities<BenchVelocity, BenchPosition>();
+    DoNotOptimize(matches.data());
+  });
+  env.Measure(std::format("query_iterate {}", count), count / 2, [&]() {
+    for (auto [position, velocity] : ecs->Query<BenchPosition, BenchVelocity>()) {
+      position->x += velocity->x;
+    }
+    DoNotOptimize(ecs.get());
+  });
+  env.Measure(std::format("iterate_entities {}", count), count, [&]() {
+    size_t alive = 0;
+    for (auto e : *ecs) {
+      alive += e.IsAlive();
+    }
+    DoNotOptimize(alive);
+  });
+}
+
+END_BENCHMARK() // ecs_access
+
+BEGIN_BENCHMARK(ecs_copies)
+
+ECS::RegisterComponent<BenchPosition>();
+ECS::RegisterComponent<BenchVelocity>();
+
+for (uint32_t count : BENCHMARK_ENTITY_COUNTS) {
+  std::unique_ptr<ECS> source = MakeBenchmarkECS(count);
+  std::unique_ptr<ECS> target;
+  std::vector<std::byte> snapshot(source->Snapshot({}));
+
+  env.Measure(
+      std::format("copy_into_empty {}", count), count, [&]() { target = std::make_unique<ECS>(); },
+      [&]() { target->Copy(source.get()); });
+  env.Measure(
+      std::format("copy_into_populated {}", count), count,
+      [&]() {
+        target = std::make_unique<ECS>();
+        target->CreateEntity();
+      },
+      [&]() { target->Copy(source.get()); });
+  env.Measure(std::format("snapshot {}", count), count, [&]() { source->Snapshot(snapshot); });
+  env.Measure(
+      std::format("restore {}", count), count, [&]() { target = std::make_unique<ECS>(); },
+      [&]() { target->Restore(snapshot); });
+}
+
+END_BENCHMARK() // ecs_copies
+
+BEGIN_BENCHMARK(ecs)
+
+RUN_BENCHMARK(ecs_entities)
+RUN_BENCHMARK(ecs_access)
+RUN_BENCHMARK(ecs_copies)
+
+END_BENCHMARK() // ecs
+
+} // namespace Engine::Test
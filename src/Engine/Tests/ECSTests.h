@@ -0,0 +1,956 @@
+#pragma once
+
+#include "Test.h"
+
+#include "Core/ECS.h"
+#include "Core/ECSCommandBuffer.h"
+#include "Core/HierarchyComponent.h"
+#include "Core/SceneRunner.h"
+#include "Core/SystemScheduler.h"
+#include "Util/ThreadPool.h"
+
+using namespace Engine::Core;
+
+namespace Engine::Test {
+
+struct TestPosition : public ComponentT<TestPosition> {
+  float x = 0, y = 0, z = 0;
+  TestPosition(Entity entity) : ComponentT<TestPosition>(entity) {}
+  inline void CopyFrom(TestPosition const &other) override {
+    x = other.x;
+    y = other.y;
+    z = other.z;
+  }
+  inline void Serialize(SnapshotWriter &writer) const { writer.Write(x, y, z); }
+  inline void Deserialize(SnapshotReader &reader) { reader.Read(x, y, z); }
+};
+
+struct TestVelocity : public ComponentT<TestVelocity> {
+  float speed = 0;
+  TestVelocity(Entity entity) : ComponentT<TestVelocity>(entity) {}
+  inline void CopyFrom(TestVelocity const &other) override { speed = other.speed; }
+  inline void Serialize(SnapshotWriter &writer) const { writer.Write(speed); }
+  inline void Deserialize(SnapshotReader &reader) { reader.Read(speed); }
+};
+
+struct TestStatic {}; // Tags
+struct TestShadowCaster {};
+
+struct TestLighting { // Resource
+  float intensity;
+  TestLighting(float intensity) : intensity(intensity) {}
+};
+
+struct TestOwner : public ComponentT<TestOwner> { // Not copy constructible
+  std::unique_ptr<int> value;
+  TestOwner(Entity entity) : ComponentT<TestOwner>(entity), value(std::make_unique<int>(0)) {}
+  inline void CopyFrom(TestOwner const &other) override { *value = *other.value; }
+};
+
+template <int N> struct TestTag : public ComponentT<TestTag<N>> {
+  TestTag(Entity entity) : ComponentT<TestTag<N>>(entity) {}
+  inline void CopyFrom(TestTag<N> const &) override {}
+};
+
+BEGIN_TEST_CASE(component_pools)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+std::vector<Entity> entities{};
+for (int i = 0; i < 100; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>()->x = float(i);
+  if (i % 2 == 0) {
+    e.AddComponent<TestVelocity>()->speed = float(i);
+  }
+  entities.push_back(e);
+}
+
+for (int i = 0; i < 100; i += 3) {
+  entities[i].RemoveComponent<TestPosition>();
+}
+TEST_ASSERT(!entities[0].HasComponent<TestPosition>(), "Removed component is still attached!")
+TEST_ASSERT(entities[1].HasComponent<TestPosition>(), "Component got lost while removing another one!")
+
+bool positionsIntact = true;
+for (int i = 0; i < 100; i++) {
+  if (i % 3 != 0 && entities[i].GetComponent<TestPosition>()->x != float(i)) {
+    positionsIntact = false;
+  }
+}
+TEST_ASSERT(positionsIntact, "Swap-remove mixed up the components of different entities!")
+
+size_t matches = 0;
+bool matchesConsistent = true;
+for (auto &[position, velocity] : ecs.FilterEntities<TestPosition, TestVelocity>()) {
+  matches++;
+  matchesConsistent &= position->entity == velocity->entity && position->x == velocity->speed;
+}
+TEST_ASSERT(matches == 33, "Filter returned {} instead of 33 entities!", matches)
+TEST_ASSERT(matchesConsistent, "Filter returned components of different entities in the same tuple!")
+
+entities[4].Destroy();
+TEST_ASSERT(!entities[4].IsAlive(), "Destroyed entity is still alive!")
+TEST_ASSERT(entities[5].GetComponent<TestPosition>()->x == 5.0f, "Destroying an entity corrupted the pool!")
+
+END_TEST_CASE() // component_pools
+
+BEGIN_TEST_CASE(hierarchy_copies)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<TestPosition>();
+
+ECS ecs{};
+Entity root = ecs.CreateEntity();
+root.AddComponent<HierarchyComponent>();
+root.AddComponent<TestPosition>()->x = 1;
+for (int i = 0; i < 20; i++) { // Enough children to make the pools grow while copying
+  Entity child = ecs.CreateEntity();
+  child.AddComponent<HierarchyComponent>()->parent = root;
+  child.AddComponent<TestPosition>()->x = float(i);
+  root.GetComponent<HierarchyComponent>()->children.push_back(child);
+}
+
+ECS otherECS{};
+Entity copy = root.CopyToOtherECS(&otherECS);
+auto const &copiedChildren = copy.GetComponent<HierarchyComponent>()->children;
+TEST_ASSERT(copiedChildren.size() == 20, "Copy has {} instead of 20 children!", copiedChildren.size())
+bool childrenIntact = true;
+for (size_t i = 0; i < copiedChildren.size(); i++) {
+  childrenIntact &= copiedChildren[i].GetComponent<HierarchyComponent>()->parent == copy &&
+                    copiedChildren[i].GetComponent<TestPosition>()->x == float(i);
+}
+TEST_ASSERT(childrenIntact, "Children were not copied correctly!")
+
+Entity duplicate = root.Duplicate();
+TEST_ASSERT(duplicate.GetComponent<HierarchyComponent>()->children.size() == 20, "Duplicate lost its children!")
+TEST_ASSERT(root.GetComponent<HierarchyComponent>()->children.size() == 20, "Duplicating changed the original!")
+
+END_TEST_CASE() // hierarchy_copies
+
+BEGIN_TEST_CASE(queries)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+auto moving = ecs.Query<TestPosition, TestVelocity>();
+std::vector<Entity> entities{};
+for (int i = 0; i < 10; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>();
+  entities.push_back(e);
+}
+TEST_ASSERT(moving.Empty(), "Query matched entities without all components!")
+
+for (int i = 0; i < 10; i += 2) {
+  entities[i].AddComponent<TestVelocity>()->speed = float(i);
+}
+TEST_ASSERT(moving.Size() == 5, "Query did not pick up added components ({} matches)!", moving.Size())
+
+entities[0].SetActive(false);
+entities[2].RemoveComponent<TestVelocity>();
+entities[4].Destroy();
+TEST_ASSERT(moving.Size() == 2, "Query did not drop changed entities ({} matches)!", moving.Size())
+auto movingIncludingInactive = ecs.Query<TestPosition, TestVelocity>(false);
+TEST_ASSERT(movingIncludingInactive.Size() == 3, "Query ignoring activity is wrong!")
+
+bool matchesConsistent = true;
+for (auto [position, velocity] : moving) {
+  matchesConsistent &= position->entity == velocity->entity && velocity->entity.IsActive();
+}
+TEST_ASSERT(matchesConsistent, "Query returned wrong components!")
+
+entities[0].SetActive(true);
+TEST_ASSERT(moving.Size() == 3, "Query did not pick up reactivated entity!")
+
+END_TEST_CASE() // queries
+
+BEGIN_TEST_CASE(parallel_for_each)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+for (int i = 0; i < 1000; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>()->x = float(i);
+  if (i % 4 != 0) {
+    e.AddComponent<TestVelocity>()->speed = float(i);
+  }
+}
+
+std::vector<int> visits(750, 0);
+ecs.ParallelForEach<TestPosition, TestVelocity>(
+    [&visits](size_t i, TestPosition *position, TestVelocity *velocity) {
+      visits[i]++;
+      position->x += velocity->speed;
+    },
+    16);
+TEST_ASSERT(std::ranges::all_of(visits, [](int v) { return v == 1; }), "Not every match was visited exactly once!")
+
+bool positionsMoved = true;
+for (auto [position, velocity] : ecs.Query<TestPosition, TestVelocity>()) {
+  positionsMoved &= position->x == 2 * velocity->speed;
+}
+TEST_ASSERT(positionsMoved, "ParallelForEach handed out the wrong components!")
+
+END_TEST_CASE() // parallel_for_each
+
+BEGIN_TEST_CASE(generational_handles)
+
+ECS::RegisterComponent<TestPosition>();
+
+ECS ecs{};
+Entity first = ecs.CreateEntity();
+first.AddComponent<TestPosition>()->x = 1;
+first.Destroy();
+Entity second = ecs.CreateEntity(); // Reuses the slot of first
+second.AddComponent<TestPosition>()->x = 2;
+TEST_ASSERT(!(first == second), "Reused slot got the same handle!")
+TEST_ASSERT(!first.IsAlive(), "Stale handle is alive!")
+TEST_ASSERT(!first.HasComponent<TestPosition>(), "Stale handle sees components of the new entity!")
+TEST_ASSERT(second.GetComponent<TestPosition>()->x == 2, "New entity lost its component!")
+TEST_ASSERT(!ecs.IsAlive(EntityId(-1)) && !ecs.HasComponent<TestPosition>(EntityId(-1)), "Null handle is alive!")
+
+for (int i = 0; i < 70000; i++) { // More entities than 16-bit handles allowed
+  ecs.CreateEntity();
+}
+Entity last = ecs.CreateEntity();
+last.AddComponent<TestPosition>()->x = 3;
+TEST_ASSERT(last.GetComponent<TestPosition>()->x == 3 && second.GetComponent<TestPosition>()->x == 2,
+            "Growing the ECS corrupted its entities!")
+
+END_TEST_CASE() // generational_handles
+
+BEGIN_TEST_CASE(wide_masks)
+
+[]<int... Ns>(std::integer_sequence<int, Ns...>) {
+  (ECS::RegisterComponent<TestTag<Ns>>(), ...);
+}(std::make_integer_sequence<int, 70>());
+TEST_ASSERT(ComponentID<TestTag<69>>::value >= 64, "Not enough component types registered!")
+
+ECS ecs{};
+auto tagged = ecs.Query<TestTag<0>, TestTag<69>>();
+for (int i = 0; i < 10; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestTag<69>>();
+  if (i % 2 == 0) {
+    e.AddComponent<TestTag<0>>();
+  }
+}
+TEST_ASSERT(tagged.Size() == 5, "Query over wide mask has {} instead of 5 matches!", tagged.Size())
+
+bool tagsConsistent = true;
+for (auto [low, high] : tagged) {
+  tagsConsistent &= low->entity.HasComponent<TestTag<69>>() && !low->entity.HasComponent<TestTag<68>>();
+}
+TEST_ASSERT(tagsConsistent, "Component bits beyond 64 are mixed up!")
+
+END_TEST_CASE() // wide_masks
+
+BEGIN_TEST_CASE(memory_report)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+std::vector<Entity> entities{};
+for (int i = 0; i < 10; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>();
+  e.AddComponent<TestVelocity>();
+  entities.push_back(e);
+}
+auto smallReport = ecs.GetMemoryReport();
+TEST_ASSERT(smallReport.Total() < 16 * 1024, "Small ECS takes up {} bytes!", smallReport.Total())
+
+for (int i = 0; i < 2000; i++) {
+  entities.push_back(ecs.CreateEntity());
+}
+entities.back().AddComponent<TestPosition>();
+auto grownReport = ecs.GetMemoryReport();
+TEST_ASSERT(grownReport.indexMapBytes > smallReport.indexMapBytes, "Index maps did not grow!")
+
+entities.back().Destroy();
+TEST_ASSERT(ecs.GetMemoryReport().indexMapBytes < grownReport.indexMapBytes, "Unused index map pages were kept!")
+
+END_TEST_CASE() // memory_report
+
+BEGIN_TEST_CASE(bulk_creation)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+auto moving = ecs.Query<TestPosition, TestVelocity>();
+std::vector<EntityId> entities = ecs.CreateEntities(3000);
+ecs.AddComponents<TestPosition, TestVelocity>(entities);
+TEST_ASSERT(moving.Size() == 3000, "Query has {} instead of 3000 bulk created entities!", moving.Size())
+
+ecs.DestroyEntity(entities[10]);
+ecs.DestroyEntity(entities[20]);
+std::vector<EntityId> moreEntities = ecs.CreateEntities(5);
+ecs.AddComponents<TestPosition>(moreEntities);
+bool allNew = true;
+for (EntityId e : moreEntities) {
+  allNew &= ecs.IsAlive(e) && ecs.HasComponent<TestPosition>(e) && !ecs.HasComponent<TestVelocity>(e);
+  allNew &= std::ranges::find(entities, e) == entities.end();
+}
+TEST_ASSERT(allNew, "Bulk created entities are not fresh!")
+TEST_ASSERT(!ecs.IsAlive(entities[10]), "Reused slot revived a destroyed entity!")
+TEST_ASSERT(moving.Size() == 2998, "Query has {} instead of 2998 entities!", moving.Size())
+
+END_TEST_CASE() // bulk_creation
+
+BEGIN_TEST_CASE(ecs_clones)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestOwner>();
+
+ECS ecs{};
+Entity root = ecs.CreateEntity();
+root.AddComponent<HierarchyComponent>();
+std::vector<Entity> children{};
+for (int i = 0; i < 10; i++) {
+  Entity child = ecs.CreateEntity();
+  child.AddComponent<HierarchyComponent>()->parent = root;
+  child.AddComponent<TestPosition>()->x = float(i);
+  *child.AddComponent<TestOwner>()->value = i;
+  root.GetComponent<HierarchyComponent>()->children.push_back(child);
+  children.push_back(child);
+}
+children[3].Destroy();
+std::erase(root.GetComponent<HierarchyComponent>()->children, children[3]);
+
+ECS clone{};
+clone.Copy(&ecs);
+Entity clonedRoot = root.InOtherECS(&clone);
+auto const &clonedChildren = clonedRoot.GetComponent<HierarchyComponent>()->children;
+TEST_ASSERT(clonedChildren.size() == 9, "Clone has {} instead of 9 children!", clonedChildren.size())
+bool childrenIntact = true;
+for (int i = 0; i < 10; i++) {
+  Entity clonedChild = children[i].InOtherECS(&clone);
+  if (i == 3) {
+    childrenIntact &= !clonedChild.IsAlive();
+    continue;
+  }
+  childrenIntact &= clonedChild == clonedChildren[i < 3 ? i : i - 1] &&
+                    clonedChild.GetComponent<HierarchyComponent>()->parent == clonedRoot &&
+                    clonedChild.GetComponent<TestPosition>()->entity == clonedChild &&
+                    clonedChild.GetComponent<TestPosition>()->x == float(i) &&
+                    *clonedChild.GetComponent<TestOwner>()->value == i;
+}
+TEST_ASSERT(childrenIntact, "Entities were not cloned correctly!")
+
+clonedChildren.front().GetComponent<TestPosition>()->x = 100;
+*clonedChildren.front().GetComponent<TestOwner>()->value = 100;
+TEST_ASSERT(children[0].GetComponent<TestPosition>()->x == 0 && *children[0].GetComponent<TestOwner>()->value == 0,
+            "Clone shares components with the original!")
+
+END_TEST_CASE() // ecs_clones
+
+BEGIN_TEST_CASE(change_versions)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+std::vector<Entity> entities{};
+for (int i = 0; i < 100; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>();
+  if (i % 2 == 0) {
+    e.AddComponent<TestVelocity>();
+  }
+  entities.push_back(e);
+}
+TEST_ASSERT(ecs.Changed<TestPosition>(0).size() == 100, "Added components don't count as changed!")
+
+uint32_t lastFrame = ecs.AdvanceVersion();
+TEST_ASSERT(ecs.Changed<TestPosition>(lastFrame).empty(), "Untouched components count as changed!")
+
+entities[10].ModifyComponent<TestPosition>()->x = 1;
+entities[11].MarkChanged<TestPosition>();
+entities[12].MarkChanged<TestVelocity>();
+entities[1].RemoveComponent<TestPosition>(); // Moves the last position into the gap, which must keep its version
+auto changedPositions = ecs.Changed<TestPosition>(lastFrame);
+TEST_ASSERT(changedPositions.size() == 2, "{} instead of 2 positions changed!", changedPositions.size())
+auto changedMoving = ecs.Changed<TestPosition, TestVelocity>(lastFrame);
+TEST_ASSERT(changedMoving.size() == 1 && std::get<0>(changedMoving[0])->x == 1,
+            "Changed positions weren't filtered by velocity!")
+TEST_ASSERT(ecs.Changed<TestVelocity>(lastFrame).size() == 1, "Velocity changes got lost!")
+
+lastFrame = ecs.AdvanceVersion();
+TEST_ASSERT(ecs.Changed<TestPosition>(lastFrame).empty(), "Changes of the last frame are reported again!")
+
+END_TEST_CASE() // change_versions
+
+BEGIN_TEST_CASE(command_buffers)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+std::vector<Entity> entities{};
+for (int i = 0; i < 10; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>()->x = float(i);
+  entities.push_back(e);
+}
+
+DeferredEntity spawned{};
+for (auto [position] : ecs.Query<TestPosition>()) { // Recording while iterating leaves the pools untouched
+  if (position->x == 0) {
+    spawned = position->entity.Commands().CreateEntity();
+    ecs.Commands().AddComponent<TestPosition>(spawned, [](TestPosition *p) { p->x = 42; });
+    ecs.Commands().AddComponent<TestVelocity>(spawned);
+  } else if (position->x < 5) {
+    ecs.Commands().DestroyEntity(position->entity);
+  } else {
+    ecs.Commands().AddComponent<TestVelocity>(position->entity, [](TestVelocity *v) { v->speed = 1; });
+  }
+}
+std::thread worker([&ecs, &entities]() { ecs.Commands().RemoveComponent<TestPosition>(entities[9]); });
+worker.join();
+TEST_ASSERT(ecs.Query<TestPosition>().Size() == 10, "Commands were applied before playback!")
+
+TEST_ASSERT(ecs.PlaybackCommands(), "Recorded commands were lost!")
+TEST_ASSERT(!ecs.PlaybackCommands(), "Commands were played back twice!")
+TEST_ASSERT(!entities[1].IsAlive() && !entities[4].IsAlive() && entities[5].IsAlive(), "Wrong entities destroyed!")
+TEST_ASSERT(!entities[9].HasComponent<TestPosition>(), "Command recorded on another thread was lost!")
+auto moving = ecs.FilterEntities<TestPosition, TestVelocity>();
+TEST_ASSERT(moving.size() == 5, "{} instead of 5 entities got velocities!", moving.size())
+size_t spawnedCount = std::ranges::count_if(moving, [](auto const &m) { return std::get<0>(m)->x == 42; });
+TEST_ASSERT(spawnedCount == 1, "Deferred entity was not created correctly!")
+
+// Removing and adding the same component keeps the recorded order, so the last command wins
+ecs.Commands().RemoveComponent<TestVelocity>(entities[5]);
+ecs.Commands().AddComponent<TestVelocity>(entities[5], [](TestVelocity *v) { v->speed = 2; });
+ecs.Commands().AddComponent<TestVelocity>(entities[6]);
+ecs.Commands().RemoveComponent<TestVelocity>(entities[6]);
+ecs.PlaybackCommands();
+TEST_ASSERT(entities[5].HasComponent<TestVelocity>() && entities[5].GetComponent<TestVelocity>()->speed == 2,
+            "Component removed and added again is missing!")
+TEST_ASSERT(!entities[6].HasComponent<TestVelocity>(), "Component added and removed again is still attached!")
+
+END_TEST_CASE() // command_buffers
+
+BEGIN_TEST_CASE(system_scheduler)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+for (int i = 0; i < 100; i++) {
+  ecs.CreateEntity().AddComponent<TestPosition>();
+}
+
+std::mutex logMutex{};
+std::vector<std::string> log{};
+auto logRun = [&log, &logMutex](const char *name) {
+  std::lock_guard<std::mutex> lock(logMutex);
+  log.push_back(name);
+};
+auto ranBefore = [&log](const char *first, const char *second) {
+  auto firstRun = std::ranges::find(log, first), secondRun = std::ranges::find(log, second);
+  return firstRun != log.end() && secondRun != log.end() && firstRun < secondRun;
+};
+
+bool synced = false;
+SystemScheduler scheduler{};
+scheduler.AddSystem<Reads<TestPosition>, Writes<TestVelocity>>("Spawn", [&logRun](ECS *ecs, Clock const &) {
+  for (auto [position] : ecs->Query<TestPosition>()) {
+    ecs->Commands().AddComponent<TestVelocity>(position->entity, [](TestVelocity *v) { v->speed = 1; });
+  }
+  logRun("Spawn");
+});
+scheduler.AddSystem<Reads<>, Writes<TestPosition>>("Shift", [&logRun](ECS *ecs, Clock const &) {
+  for (auto [position] : ecs->Query<TestPosition>()) {
+    position->x += 1;
+  }
+  logRun("Shift");
+});
+scheduler.AddSystem<Reads<TestPosition>>("Read", [&logRun](ECS *, Clock const &) { logRun("Read"); });
+scheduler.AddSyncPoint([&synced](ECS *) { synced = true; });
+scheduler.AddExclusiveSystem("Move", [&logRun](ECS *ecs, Clock const &) {
+  for (auto [position, velocity] : ecs->Query<TestPosition, TestVelocity>()) {
+    position->x += velocity->speed;
+  }
+  logRun("Move");
+});
+
+Util::ThreadPool pool(4);
+scheduler.Run(&ecs, Clock(), pool);
+
+TEST_ASSERT(log.size() == 4, "{} instead of 4 systems ran!", log.size())
+TEST_ASSERT(ranBefore("Spawn", "Shift") && ranBefore("Shift", "Read"), "Conflicting systems ran out of order!")
+TEST_ASSERT(ranBefore("Read", "Move"), "A system ran before the sync point it comes after!")
+TEST_ASSERT(synced, "Sync point was not reached!")
+auto moved = ecs.FilterEntities<TestPosition, TestVelocity>();
+bool movedTwice = std::ranges::all_of(moved, [](auto const &m) { return std::get<0>(m)->x == 2; });
+TEST_ASSERT(moved.size() == 100 && movedTwice, "Commands were not played back at the sync point!")
+
+END_TEST_CASE() // system_scheduler
+
+BEGIN_TEST_CASE(concurrent_queries)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+[]<int... Ns>(std::integer_sequence<int, Ns...>) {
+  (ECS::RegisterComponent<TestTag<Ns>>(), ...);
+}(std::make_integer_sequence<int, 8>());
+
+// Both systems are in one wave, and every ECS is new, so their queries are created concurrently. The thread calling
+// ParallelFor may pick up short jobs on its own, so each system waits a little for the other one.
+std::atomic<int> arrived = 0;
+auto meet = [&arrived] {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(5);
+  for (arrived++; arrived < 2 && std::chrono::steady_clock::now() < deadline;) {
+    std::this_thread::yield();
+  }
+};
+std::atomic<size_t> positions = 0, velocities = 0;
+SystemScheduler scheduler{};
+scheduler.AddSystem<Reads<>, Writes<TestPosition>>("Positions", [&positions, &meet](ECS *ecs, Clock const &) {
+  meet();
+  [&]<int... Ns>(std::integer_sequence<int, Ns...>) {
+    positions += (ecs->Query<TestPosition>(With<TestTag<Ns>>()).Size() + ...);
+  }(std::make_integer_sequence<int, 8>());
+});
+scheduler.AddSystem<Reads<>, Writes<TestVelocity>>("Velocities", [&velocities, &meet](ECS *ecs, Clock const &) {
+  meet();
+  [&]<int... Ns>(std::integer_sequence<int, Ns...>) {
+    velocities += (ecs->Query<TestVelocity>(With<TestTag<Ns>>()).Size() + ...);
+  }(std::make_integer_sequence<int, 8>());
+});
+
+Util::ThreadPool pool(2);
+for (int round = 0; round < 50; round++) {
+  ECS ecs{};
+  for (int i = 0; i < 64; i++) {
+    Entity e = ecs.CreateEntity();
+    if (i % 2 == 0) {
+      e.AddComponent<TestPosition>();
+    } else {
+      e.AddComponent<TestVelocity>();
+    }
+    [&e, tag = i % 8]<int... Ns>(std::integer_sequence<int, Ns...>) {
+      ((tag == Ns ? (void)e.AddComponent<TestTag<Ns>>() : (void)0), ...);
+    }(std::make_integer_sequence<int, 8>());
+  }
+  arrived = 0;
+  scheduler.Run(&ecs, Clock(), pool);
+}
+TEST_ASSERT(positions == 50 * 32 && velocities == 50 * 32, "Concurrently created queries matched {} and {} entities!",
+            positions.load(), velocities.load())
+
+END_TEST_CASE() // concurrent_queries
+
+BEGIN_TEST_CASE(sparse_iteration)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+ECS ecs{};
+std::vector<Entity> entities{};
+for (int i = 0; i < 1000; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>()->x = float(i);
+  if (i % 2 == 0) {
+    e.AddComponent<TestVelocity>();
+  }
+  entities.push_back(e);
+}
+for (int i = 0; i < 1000; i++) {
+  if (i % 100 != 99 && i % 300 != 0) { // Keeps 0, 99, 199, ... and 300, 600, 900
+    entities[i].Destroy();
+  }
+}
+entities[600].SetActive(false);
+
+std::vector<float> visited{};
+for (auto e : ecs) {
+  visited.push_back(e.GetComponent<TestPosition>()->x);
+}
+std::vector<float> expected{0, 99, 199, 299, 300, 399, 499, 599, 600, 699, 799, 899, 900, 999};
+TEST_ASSERT(visited == expected, "Iterated {} entities instead of the 14 alive ones!", visited.size())
+
+auto moving = ecs.FilterEntities<TestVelocity, TestPosition>();
+TEST_ASSERT(moving.size() == 3, "{} instead of 3 active entities match!", moving.size())
+TEST_ASSERT(ecs.FilterEntities<TestVelocity>(false).size() == 4, "Inactive entity was not matched!")
+size_t queried = ecs.Query<TestPosition, TestVelocity>().Size();
+TEST_ASSERT(queried == 3, "Query was filled with {} entities!", queried)
+
+ECS copy{};
+copy.CreateEntity();
+copy.Copy(&ecs);
+size_t copied = 0;
+for (auto e : copy) {
+  copied += e.IsAlive();
+}
+TEST_ASSERT(copied == 15, "{} instead of 15 entities after copying!", copied)
+
+END_TEST_CASE() // sparse_iteration
+
+BEGIN_TEST_CASE(snapshots)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+ECS::RegisterComponent<TestOwner>();
+
+ECS ecs{};
+std::vector<Entity> entities{};
+for (int i = 0; i < 100; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>()->x = float(i);
+  if (i % 3 == 0) {
+    e.AddComponent<TestVelocity>()->speed = float(i);
+  }
+  entities.push_back(e);
+}
+for (int i = 0; i < 100; i += 7) {
+  entities[i].Destroy();
+}
+entities[50].SetActive(false);
+entities[1].AddComponent<HierarchyComponent>();
+entities[2].AddComponent<HierarchyComponent>()->SetParent(entities[1].GetComponent<HierarchyComponent>());
+
+std::vector<std::byte> snapshot(ecs.Snapshot({}));
+TEST_ASSERT(ecs.Snapshot(snapshot) == snapshot.size(), "Snapshot changed its size!")
+
+Entity created = ecs.CreateEntity();
+for (auto e : entities) {
+  if (e.IsAlive()) {
+    e.Destroy();
+  }
+}
+TEST_ASSERT(ecs.Restore(snapshot), "Restoring failed!")
+
+bool restored = true;
+for (int i = 0; i < 100; i++) {
+  restored &= entities[i].IsAlive() == (i % 7 != 0);
+  if (i % 7 != 0) {
+    restored &= entities[i].GetComponent<TestPosition>()->x == float(i);
+    restored &= entities[i].HasComponent<TestVelocity>() == (i % 3 == 0);
+  }
+}
+TEST_ASSERT(restored, "Entities were not restored correctly!")
+TEST_ASSERT(!created.IsAlive(), "Entity created after the snapshot survived!")
+TEST_ASSERT(!entities[50].IsActive(), "Activity was not restored!")
+TEST_ASSERT(entities[2].GetComponent<HierarchyComponent>()->parent == entities[1] &&
+                entities[1].GetComponent<HierarchyComponent>()->children.size() == 1,
+            "Hierarchy was not restored!")
+auto moving = ecs.FilterEntities<TestVelocity>();
+TEST_ASSERT(moving.size() == 29, "{} instead of 29 entities match after restoring!", moving.size())
+TEST_ASSERT(ecs.CreateEntity() == created, "Free slots were not restored!") // Gets the same handle again
+
+ECS other{};
+TEST_ASSERT(other.Restore(snapshot), "Restoring into another ECS failed!")
+Entity copy = entities[13].InOtherECS(&other);
+TEST_ASSERT(copy.IsAlive() && copy.GetComponent<TestPosition>()->x == 13, "Snapshot depends on the original ECS!")
+TEST_ASSERT(entities[2].InOtherECS(&other).GetComponent<HierarchyComponent>()->parent == entities[1].InOtherECS(&other),
+            "Hierarchy handles were not moved to the other ECS!")
+
+TEST_ASSERT(!other.Restore(std::span(snapshot).first(snapshot.size() / 2)), "Truncated snapshot was restored!")
+TEST_ASSERT(other.begin() == other.end(), "Failed restore left entities behind!")
+
+// Component bits have to be backed by their pools, whether the type has no pool in the snapshot or not
+auto withBit = [&snapshot](size_t index, componentID c) {
+  std::vector<std::byte> corrupt = snapshot;
+  std::byte *flags = corrupt.data() + 4 * sizeof(uint32_t) + index * sizeof(ComponentMask);
+  ComponentMask mask{};
+  std::memcpy(&mask, flags, sizeof(ComponentMask));
+  mask.Set(c);
+  std::memcpy(flags, &mask, sizeof(ComponentMask));
+  return corrupt;
+};
+TEST_ASSERT(!other.Restore(withBit(1, ComponentID<TestOwner>::value)), "Component type without pool was restored!")
+TEST_ASSERT(!other.Restore(withBit(1, ComponentID<TestVelocity>::value)), "Component missing in its pool was restored!")
+TEST_ASSERT(other.Restore(withBit(1, ComponentID<TestPosition>::value)), "Unchanged snapshot was not restored!")
+
+// Handles of alive entities have to name their own slot. Pools check the handles of their entities already, so the
+// entities have no components.
+ECS bare{};
+bare.CreateEntity();
+bare.CreateEntity();
+std::vector<std::byte> swapped(bare.Snapshot({}));
+bare.Snapshot(swapped);
+std::byte *handleData = swapped.data() + 4 * sizeof(uint32_t) + 2 * sizeof(ComponentMask);
+std::memcpy(handleData, handleData + sizeof(EntityId), sizeof(EntityId));
+TEST_ASSERT(!other.Restore(swapped), "Handle stored in the wrong slot was restored!")
+
+// Other ECSs could only be written as addresses, which must not be read back
+ECS outside{};
+Entity outsider = outside.CreateEntity();
+outsider.AddComponent<HierarchyComponent>();
+entities[5].AddComponent<HierarchyComponent>()->parent = outsider;
+TEST_ASSERT(ecs.Snapshot(snapshot) == 0, "Reference to another ECS was written!")
+entities[5].RemoveComponent<HierarchyComponent>();
+std::array<std::byte, 1 + sizeof(EntityId) + sizeof(uintptr_t)> foreignEntity{std::byte(2)};
+SnapshotReader foreignReader(foreignEntity, &other);
+Entity foreign{};
+foreignReader.Read(foreign);
+TEST_ASSERT(foreignReader.Failed() && !foreign.IsAlive(), "Entity with unknown owner was read!")
+
+entities[3].AddComponent<TestOwner>();
+TEST_ASSERT(ecs.Snapshot(snapshot) == 0, "Component without Serialize function was written!")
+
+END_TEST_CASE() // snapshots
+
+BEGIN_TEST_CASE(multi_scene)
+
+// Types registered from several threads at once still get one ID each
+auto registerTags = []() {
+  ECS::RegisterComponent<TestTag<100>>();
+  ECS::RegisterComponent<TestTag<101>>();
+  ECS::RegisterComponent<TestTag<102>>();
+  ECS::RegisterComponent<TestTag<103>>();
+};
+std::vector<std::thread> registrars{};
+for (int i = 0; i < 4; i++) {
+  registrars.emplace_back(registerTags);
+}
+for (auto &registrar : registrars) {
+  registrar.join();
+}
+std::array<componentID, 4> tagIDs{ComponentID<TestTag<100>>::value, ComponentID<TestTag<101>>::value,
+                                  ComponentID<TestTag<102>>::value, ComponentID<TestTag<103>>::value};
+std::ranges::sort(tagIDs);
+bool distinct = std::ranges::adjacent_find(tagIDs) == tagIDs.end() && tagIDs.back() < MAX_COMPONENT_NUMBER;
+TEST_ASSERT(distinct, "Concurrent registrations handed out the same component ID!")
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestVelocity>();
+
+SystemScheduler scheduler{};
+scheduler.AddSystem<Reads<>, Writes<TestPosition>>("Shift", [](ECS *ecs, Clock const &) {
+  for (auto [position] : ecs->Query<TestPosition>()) {
+    position->x += 1;
+  }
+});
+scheduler.AddExclusiveSystem("Spawn", [](ECS *ecs, Clock const &) {
+  ecs->Commands().AddComponent<TestVelocity>(ecs->Commands().CreateEntity());
+});
+
+Util::ThreadPool pool(4);
+SceneRunner runner(&scheduler, pool);
+std::vector<std::unique_ptr<Scene>> scenes{};
+for (int i = 0; i < 8; i++) {
+  Scene *scene = scenes.emplace_back(std::make_unique<Scene>()).get();
+  for (int j = 0; j <= 10 * i; j++) {
+    scene->ecs.CreateEntity().AddComponent<TestPosition>();
+  }
+  runner.AddScene(scene);
+}
+runner.AddScene(scenes[0].get());
+TEST_ASSERT(runner.SceneCount() == 8, "Scene was added to the runner twice!")
+
+for (int update = 0; update < 5; update++) {
+  runner.Update();
+}
+
+for (int i = 0; i < 8; i++) {
+  ECS &ecs = scenes[i]->ecs;
+  auto positions = ecs.FilterEntities<TestPosition>();
+  bool shifted = std::ranges::all_of(positions, [](auto const &p) { return std::get<0>(p)->x == 5; });
+  TEST_ASSERT(positions.size() == size_t(10 * i + 1) && shifted, "Scene {} was not updated in isolation!", i)
+  size_t spawned = ecs.FilterEntities<TestVelocity>().size();
+  TEST_ASSERT(spawned == 5, "Scene {} spawned {} instead of 5 entities!", i, spawned)
+  TEST_ASSERT(scenes[i]->sceneHierarchy.roots.size() == positions.size() + 5,
+              "Hierarchy of scene {} missed spawned entities!", i)
+}
+
+runner.RemoveScene(scenes[3].get());
+runner.Update();
+TEST_ASSERT(scenes[3]->ecs.FilterEntities<TestVelocity>().size() == 5, "Removed scene was still updated!")
+
+// A system added between updates is ordered once, before the scenes run
+std::atomic<int> counted = 0;
+scheduler.AddSystem<Reads<TestPosition>>("Count", [&counted](ECS *, Clock const &) { counted++; });
+runner.Update();
+TEST_ASSERT(counted == 7, "Added system ran on {} instead of 7 scenes!", counted.load())
+
+END_TEST_CASE() // multi_scene
+
+BEGIN_TEST_CASE(scene_hierarchy)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<TestPosition>();
+
+// Roots are counted again from scratch, which is what the incremental updates have to match
+auto countRoots = [](ECS &ecs) {
+  size_t count = 0;
+  for (auto e : ecs) {
+    count += !e.HasComponent<HierarchyComponent>() || !e.GetComponent<HierarchyComponent>()->parent.IsAlive();
+  }
+  return count;
+};
+
+Scene scene{};
+Entity prefab = scene.ecs.CreateEntity();
+prefab.AddComponent<HierarchyComponent>();
+std::vector<Entity> children{};
+for (int i = 0; i < 3; i++) {
+  Entity child = scene.ecs.CreateEntity();
+  child.AddComponent<HierarchyComponent>()->SetParent(prefab.GetComponent<HierarchyComponent>());
+  children.push_back(child);
+}
+scene.ecs.CreateEntity().AddComponent<TestPosition>();
+TEST_ASSERT(scene.sceneHierarchy.roots.size() == 2 && scene.sceneHierarchy.IsRoot(prefab) &&
+                !scene.sceneHierarchy.IsRoot(children[0]),
+            "Parenting did not update the roots!")
+size_t childNodes = 0;
+for (auto node : scene.sceneHierarchy) {
+  for (auto child : node) {
+    childNodes += !child.HasChildren();
+  }
+}
+TEST_ASSERT(childNodes == 3, "Tree has {} instead of 3 leaves!", childNodes)
+
+Entity instance = scene.InstantiateEntity(prefab);
+TEST_ASSERT(scene.sceneHierarchy.roots.size() == 3 && scene.sceneHierarchy.IsRoot(instance),
+            "Instantiated prefab is not a single root!")
+
+children[1].GetComponent<HierarchyComponent>()->SetParent(nullptr);
+prefab.Destroy();
+TEST_ASSERT(scene.sceneHierarchy.roots.size() == countRoots(scene.ecs) && scene.sceneHierarchy.IsRoot(children[0]),
+            "Children of a destroyed entity did not become roots!")
+
+std::vector<std::byte> snapshot(scene.ecs.Snapshot({}));
+scene.ecs.Snapshot(snapshot);
+Scene restored{};
+restored.ecs.Restore(snapshot);
+TEST_ASSERT(restored.sceneHierarchy.roots.size() == scene.sceneHierarchy.roots.size(),
+            "Restoring a snapshot did not rebuild the roots!")
+
+END_TEST_CASE() // scene_hierarchy
+
+BEGIN_TEST_CASE(hierarchy_activity)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<TestPosition>();
+
+ECS ecs{};
+std::vector<Entity> chain{};
+for (int i = 0; i < 4; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>()->x = float(i);
+  e.AddComponent<HierarchyComponent>();
+  if (i > 0) {
+    e.GetComponent<HierarchyComponent>()->SetParent(chain.back().GetComponent<HierarchyComponent>());
+  }
+  chain.push_back(e);
+}
+auto visible = ecs.Query<TestPosition>(With<ActiveInHierarchy>());
+TEST_ASSERT(visible.Size() == 4, "New hierarchy is not active!")
+
+chain[1].SetActive(false);
+TEST_ASSERT(visible.Size() == 1 && chain[3].IsActive() && !chain[3].IsActiveInHierarchy(),
+            "Deactivating a parent did not reach its subtree!")
+chain[2].SetActive(false);
+chain[1].SetActive(true);
+TEST_ASSERT(visible.Size() == 2 && !chain[3].IsActiveInHierarchy(), "Inactive child was activated with its parent!")
+
+chain[3].GetComponent<HierarchyComponent>()->SetParent(chain[0].GetComponent<HierarchyComponent>());
+TEST_ASSERT(chain[3].IsActiveInHierarchy(), "Moving out of an inactive subtree did not activate the entity!")
+chain[3].GetComponent<HierarchyComponent>()->SetParent(chain[2].GetComponent<HierarchyComponent>());
+chain[2].SetActive(true);
+chain[1].SetActive(false);
+chain[1].Destroy();
+TEST_ASSERT(visible.Size() == 3 && chain[2].IsActiveInHierarchy(), "Children of a destroyed parent stayed inactive!")
+
+Entity copy = chain[2].Duplicate();
+chain[2].SetActive(false);
+TEST_ASSERT(!copy.GetComponent<HierarchyComponent>()->children.empty() && visible.Size() == 3,
+            "Copied hierarchy is not active on its own!")
+
+END_TEST_CASE() // hierarchy_activity
+
+BEGIN_TEST_CASE(tags_and_resources)
+
+ECS::RegisterComponent<TestPosition>();
+ECS::RegisterComponent<TestStatic>();
+ECS::RegisterComponent<TestShadowCaster>();
+
+ECS ecs{};
+std::vector<Entity> entities{};
+for (int i = 0; i < 100; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<TestPosition>()->x = float(i);
+  if (i % 2 == 0) {
+    e.AddTag<TestStatic>();
+  }
+  if (i % 3 == 0) {
+    e.AddTag<TestShadowCaster>();
+  }
+  entities.push_back(e);
+}
+size_t componentBytes = ecs.GetMemoryReport().componentBytes;
+TEST_ASSERT(entities[4].HasTag<TestStatic>() && !entities[5].HasTag<TestStatic>(), "Tags were not attached!")
+TEST_ASSERT(entities[4].GetComponents().size() == 1, "Tags were returned as components!")
+
+auto staticPositions = ecs.FilterEntities<TestPosition>(With<TestStatic>());
+bool allEven = std::ranges::all_of(staticPositions, [](auto const &p) { return int(std::get<0>(p)->x) % 2 == 0; });
+TEST_ASSERT(staticPositions.size() == 50 && allEven, "Filtering by tag matched {} entities!", staticPositions.size())
+size_t staticCasters = ecs.EntitiesWith<TestStatic, TestShadowCaster>().size();
+TEST_ASSERT(staticCasters == 17, "Tags were not intersected!")
+auto casters = ecs.Query<TestPosition>(With<TestShadowCaster>());
+TEST_ASSERT(casters.Size() == 34, "Query by tag matched {} entities!", casters.Size())
+
+entities[0].RemoveTag<TestShadowCaster>();
+entities[1].Commands().AddTag<TestShadowCaster>(entities[1]);
+ecs.PlaybackCommands();
+TEST_ASSERT(casters.Size() == 34 && entities[1].HasTag<TestShadowCaster>(), "Cached query missed tag changes!")
+TEST_ASSERT(ecs.GetMemoryReport().componentBytes == componentBytes, "Tags take up component storage!")
+entities[3].Destroy();
+TEST_ASSERT(ecs.EntitiesWith<TestShadowCaster>().size() == 33, "Tag outlived its entity!")
+
+ECS copy{};
+copy.Copy(&ecs);
+TEST_ASSERT(copy.EntitiesWith<TestShadowCaster>().size() == 33, "Tags were not copied!")
+std::vector<std::byte> snapshot(ecs.Snapshot({}));
+ecs.Snapshot(snapshot);
+ECS restored{};
+TEST_ASSERT(restored.Restore(snapshot), "Snapshot with tags was not restored!")
+TEST_ASSERT(restored.FilterEntities<TestPosition>(With<TestStatic>()).size() == 50, "Tags were not restored!")
+
+TEST_ASSERT(!ecs.GetResource<TestLighting>(), "Resource exists before it was emplaced!")
+ecs.EmplaceResource<TestLighting>(0.5f);
+ecs.EmplaceResource<TestLighting>(2.0f)->intensity *= 2;
+TEST_ASSERT(ecs.GetResource<TestLighting>()->intensity == 4.0f, "Resource was not replaced!")
+TEST_ASSERT(!copy.GetResource<TestLighting>(), "Resources are shared between ECSs!")
+ecs.RemoveResource<TestLighting>();
+TEST_ASSERT(!ecs.GetResource<TestLighting>(), "Resource was not removed!")
+
+END_TEST_CASE() // tags_and_resources
+
+BEGIN_TEST_CASE(ecs)
+
+RUN_SUB_CASE(component_pools)
+RUN_SUB_CASE(hierarchy_copies)
+RUN_SUB_CASE(queries)
+RUN_SUB_CASE(parallel_for_each)
+RUN_SUB_CASE(generational_handles)
+RUN_SUB_CASE(wide_masks)
+RUN_SUB_CASE(memory_report)
+RUN_SUB_CASE(bulk_creation)
+RUN_SUB_CASE(ecs_clones)
+RUN_SUB_CASE(change_versions)
+RUN_SUB_CASE(command_buffers)
+RUN_SUB_CASE(system_scheduler)
+RUN_SUB_CASE(concurrent_queries)
+RUN_SUB_CASE(sparse_iteration)
+RUN_SUB_CASE(snapshots)
+RUN_SUB_CASE(multi_scene)
+RUN_SUB_CASE(scene_hierarchy)
+RUN_SUB_CASE(hierarchy_activity)
+RUN_SUB_CASE(tags_and_resources)
+
+END_TEST_CASE() // ecs
+
+} // namespace Engine::Test
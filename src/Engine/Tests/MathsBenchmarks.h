@@ -0,0 +1,339 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include "Maths/Batch.h"
+#include "Maths/Matrix3x4.h"
+#include "Maths/Transformations.h"
+
+#include <random>
+
+using namespace Engine::Maths;
+
+namespace Engine::Test {
+
+#define MATHS_BENCHMARK_SIZE 1024 // Operands per run, small enough to stay in L1/L2
+#define MATHS_BATCH_BENCHMARK_SIZE (1 << 16) // Large enough for batches to be split across threads
+
+// Fixed seed, so that every run works on the same operands
+class BenchmarkOperands {
+  std::mt19937 generator;
+  std::uniform_real_distribution<float> distribution;
+
+public:
+  BenchmarkOperands() : generator(5489u), distribution(-1.0f, 1.0f) {}
+
+  inline float Next() { return distribution(generator); }
+  template <uint8_t n, uint8_t m> inline std::vector<MatrixNM<n, m>> Matrices() {
+    std::vector<MatrixNM<n, m>> matrices(MATHS_BENCHMARK_SIZE);
+    for (auto &matrix : matrices) {
+      for (uint8_t row = 0; row < n; row++) {
+        for (uint8_t col = 0; col < m; col++) {
+          float value = Next() + (row == col ? 2.0f : 0.0f); // Diagonally dominant, so that inverses exist
+          if constexpr (m == 1) {
+            matrix[row] = value;
+          } else {
+            matrix[row][col] = value;
+          }
+        }
+      }
+    }
+    return matrices;
+  }
+  inline std::vector<Quaternion> Rotations() {
+    std::vector<Quaternion> rotations(MATHS_BENCHMARK_SIZE);
+    for (auto &rotation : rotations) {
+      rotation = Transformations::RotateAroundAxis(Vector3{Next(), Next(), Next()}.Normalized(), 3.14159f * Next());
+    }
+    return rotations;
+  }
+  inline std::vector<Matrix3x4> Affines() {
+    std::vector<Quaternion> rotations = Rotations();
+    std::vector<Matrix3x4> affines(MATHS_BENCHMARK_SIZE);
+    for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+      Vector3 scale{Next() + 2.0f, Next() + 2.0f, Next() + 2.0f}; // Away from zero, so that inverses exist
+      affines[i] = Matrix3x4::FromTRS({Next(), Next(), Next()}, rotations[i], scale);
+    }
+    return affines;
+  }
+};
+
+BEGIN_BENCHMARK(maths_matrices)
+
+BenchmarkOperands operands{};
+auto A = operands.Matrices<4, 4>();
+auto B = operands.Matrices<4, 4>();
+auto v = operands.Matrices<4, 1>();
+auto A3 = operands.Matrices<3, 3>();
+auto B3 = operands.Matrices<3, 3>();
+std::vector<Matrix4> results4(MATHS_BENCHMARK_SIZE);
+std::vector<Matrix3> results3(MATHS_BENCHMARK_SIZE);
+std::vector<Vector4> resultVectors(MATHS_BENCHMARK_SIZE);
+auto affineA = operands.Affines();
+auto affineB = operands.Affines();
+std::vector<Matrix3x4> resultAffines(MATHS_BENCHMARK_SIZE);
+auto u = operands.Matrices<3, 1>();
+auto w = operands.Matrices<3, 1>();
+std::vector<Vector3> resultVectors3(MATHS_BENCHMARK_SIZE);
+
+env.Measure("matrix4_multiply", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    results4[i] = A[i] * B[i];
+  }
+  DoNotOptimize(results4.data());
+});
+env.Measure("matrix4_vector4", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    resultVectors[i] = A[i] * v[i];
+  }
+  DoNotOptimize(resultVectors.data());
+});
+env.Measure("matrix4_inverse", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    results4[i] = A[i].Inverse();
+  }
+  DoNotOptimize(results4.data());
+});
+env.Measure("matrix4_transpose", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    results4[i] = A[i].Transposed();
+  }
+  DoNotOptimize(results4.data());
+});
+env.Measure("matrix3_multiply", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    results3[i] = A3[i] * B3[i];
+  }
+  DoNotOptimize(results3.data());
+});
+env.Measure("affine_multiply", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    resultAffines[i] = affineA[i] * affineB[i];
+  }
+  DoNotOptimize(resultAffines.data());
+});
+env.Measure("affine_inverse", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    resultAffines[i] = affineA[i].Inverse();
+  }
+  DoNotOptimize(resultAffines.data());
+});
+env.Measure("affine_inverse_trs", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    resultAffines[i] = affineA[i].InverseTRS();
+  }
+  DoNotOptimize(resultAffines.data());
+});
+env.Measure("matrix4_construct", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    float s = v[i][X];
+    results4[i] = Matrix4{s, 0, 0, v[i][Y], 0, s, 0, v[i][Z], 0, 0, s, v[i][W], 0, 0, 0, 1};
+  }
+  DoNotOptimize(results4.data());
+});
+env.Measure("matrix4_identity", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    results4[i] = Matrix4::Identity();
+  }
+  DoNotOptimize(results4.data());
+});
+env.Measure("vector3_chain", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    resultVectors3[i] = u[i] + w[i] * 0.5f - u[(i + 1) % MATHS_BENCHMARK_SIZE] / 3.0f + 1.0f;
+  }
+  DoNotOptimize(resultVectors3.data());
+});
+env.Measure("vector4_normalize", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    resultVectors[i] = v[i].Normalized();
+  }
+  DoNotOptimize(resultVectors.data());
+});
+
+END_BENCHMARK() // maths_matrices
+
+BEGIN_BENCHMARK(maths_quaternions)
+
+BenchmarkOperands operands{};
+auto p = operands.Rotations();
+auto q = operands.Rotations();
+auto points = operands.Matrices<3, 1>();
+std::vector<Quaternion> results(MATHS_BENCHMARK_SIZE);
+std::vector<Matrix3> rotationMatrices(MATHS_BENCHMARK_SIZE);
+std::vector<Vector3> rotatedPoints(MATHS_BENCHMARK_SIZE);
+
+env.Measure("quaternion_multiply", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    results[i] = p[i] * q[i];
+  }
+  DoNotOptimize(results.data());
+});
+env.Measure("quaternion_normalize", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    results[i] = (p[i] + q[i]).Normalized();
+  }
+  DoNotOptimize(results.data());
+});
+env.Measure("quaternion_rotation_matrix", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    rotationMatrices[i] = p[i].RotationMatrix();
+  }
+  DoNotOptimize(rotationMatrices.data());
+});
+env.Measure("quaternion_rotate_vector", MATHS_BENCHMARK_SIZE, [&]() {
+  for (size_t i = 0; i < MATHS_BENCHMARK_SIZE; i++) {
+    rotatedPoints[i] = Transformations::RotateByQuaternion(points[i], p[i]);
+  }
+  DoNotOptimize(rotatedPoints.data());
+});
+
+END_BENCHMARK() // maths_quaternions
+
+// Per-element operations on arrays of vectors against the batched ones on structures of arrays
+BEGIN_BENCHMARK(maths_batch)
+
+BenchmarkOperands operands{};
+size_t count = MATHS_BATCH_BENCHMARK_SIZE;
+auto affines = operands.Affines();
+Matrix3x4 matrix = affines[0];
+std::vector<Matrix3x4> matrices(count);
+std::vector<Vector3> points(count), results(count);
+Batch::Vector3Array pointStream(count), boxMax(count), resultStream(count), resultMax(count);
+for (size_t i = 0; i < count; i++) {
+  matrices[i] = affines[i % MATHS_BENCHMARK_SIZE];
+  points[i] = Vector3{operands.Next(), operands.Next(), operands.Next()};
+  pointStream.Set(i, points[i]);
+  boxMax.Set(i, points[i] + 1.0f);
+}
+std::vector<Quaternion> rotations(count), resultRotations(count);
+std::vector<Matrix3> rotationMatrices(count);
+std::vector<Matrix3x4> locals(count);
+Batch::QuaternionArray rotationStream(count), otherStream(count), resultRotationStream(count);
+auto operandRotations = operands.Rotations();
+for (size_t i = 0; i < count; i++) {
+  rotations[i] = operandRotations[i % MATHS_BENCHMARK_SIZE];
+  rotationStream.Set(i, rotations[i]);
+  otherStream.Set(i, operandRotations[(i + 1) % MATHS_BENCHMARK_SIZE]);
+}
+Quaternion spin = Transformations::RotateAroundAxis({0, 1, 0}, 0.01f);
+Util::ThreadPool *pool = &Util::ThreadPool::Shared();
+
+env.Measure("transform_points_aos", count, [&]() {
+  for (size_t i = 0; i < count; i++) {
+    results[i] = matrix.TransformPoint(points[i]);
+  }
+  DoNotOptimize(results.data());
+});
+env.Measure("transform_points_soa", count, [&]() {
+  Batch::TransformPoints(matrix, pointStream, resultStream);
+  DoNotOptimize(resultStream.x.data());
+});
+env.Measure("transform_points_soa_threaded", count, [&]() {
+  Batch::TransformPoints(matrix, pointStream, resultStream, pool);
+  DoNotOptimize(resultStream.x.data());
+});
+env.Measure("normalize_aos", count, [&]() {
+  for (size_t i = 0; i < count; i++) {
+    results[i] = points[i].Normalized();
+  }
+  DoNotOptimize(results.data());
+});
+env.Measure("normalize_soa", count, [&]() {
+  Batch::Normalize(pointStream, resultStream);
+  DoNotOptimize(resultStream.x.data());
+});
+env.Measure("normalize_soa_threaded", count, [&]() {
+  Batch::Normalize(pointStream, resultStream, pool);
+  DoNotOptimize(resultStream.x.data());
+});
+env.Measure("bounding_boxes_soa", count, [&]() {
+  Batch::TransformBoundingBoxes(matrices, {pointStream.Span(), boxMax.Span()}, {resultStream, resultMax});
+  DoNotOptimize(resultStream.x.data());
+});
+env.Measure("bounding_boxes_soa_threaded", count, [&]() {
+  Batch::TransformBoundingBoxes(matrices, {pointStream.Span(), boxMax.Span()}, {resultStream, resultMax}, pool);
+  DoNotOptimize(resultStream.x.data());
+});
+
+// What Demo::SpinnyScript does per entity
+env.Measure("spin_aos", count, [&]() {
+  for (size_t i = 0; i < count; i++) {
+    resultRotations[i] = (spin * rotations[i]).Normalized();
+  }
+  DoNotOptimize(resultRotations.data());
+});
+env.Measure("spin_soa", count, [&]() {
+  Batch::Multiply(spin, rotationStream, resultRotationStream);
+  Batch::Normalize(resultRotationStream, resultRotationStream);
+  DoNotOptimize(resultRotationStream.w.data());
+});
+env.Measure("quaternion_multiply_soa", count, [&]() {
+  Batch::Multiply(rotationStream, otherStream, resultRotationStream);
+  DoNotOptimize(resultRotationStream.w.data());
+});
+env.Measure("nlerp_aos", count, [&]() {
+  for (size_t i = 0; i < count; i++) {
+    resultRotations[i] = Quaternion::Nlerp(rotations[i], rotationStream.Get((i + 1) % count), 0.3f);
+  }
+  DoNotOptimize(resultRotations.data());
+});
+env.Measure("nlerp_soa", count, [&]() {
+  Batch::Nlerp(rotationStream, otherStream, 0.3f, resultRotationStream);
+  DoNotOptimize(resultRotationStream.w.data());
+});
+env.Measure("slerp_aos", count, [&]() {
+  for (size_t i = 0; i < count; i++) {
+    resultRotations[i] = Quaternion::Slerp(rotations[i], rotationStream.Get((i + 1) % count), 0.3f);
+  }
+  DoNotOptimize(resultRotations.data());
+});
+env.Measure("slerp_soa", count, [&]() {
+  Batch::Slerp(rotationStream, otherStream, 0.3f, resultRotationStream);
+  DoNotOptimize(resultRotationStream.w.data());
+});
+env.Measure("rotation_matrices_aos", count, [&]() {
+  for (size_t i = 0; i < count; i++) {
+    rotationMatrices[i] = rotations[i].RotationMatrix();
+  }
+  DoNotOptimize(rotationMatrices.data());
+});
+env.Measure("rotation_matrices_soa", count, [&]() {
+  Batch::RotationMatrices(rotationStream, rotationMatrices);
+  DoNotOptimize(rotationMatrices.data());
+});
+env.Measure("from_trs_aos", count, [&]() {
+  for (size_t i = 0; i < count; i++) {
+    locals[i] = Matrix3x4::FromTRS(points[i], rotations[i], boxMax.Get(i));
+  }
+  DoNotOptimize(locals.data());
+});
+env.Measure("from_trs_soa", count, [&]() {
+  Batch::FromTRS(pointStream, rotationStream, boxMax, locals);
+  DoNotOptimize(locals.data());
+});
+env.Measure("rotate_vectors_aos", count, [&]() {
+  for (size_t i = 0; i < count; i++) {
+    results[i] = Transformations::RotateByQuaternion(points[i], rotations[i]);
+  }
+  DoNotOptimize(results.data());
+});
+env.Measure("rotate_vectors_soa", count, [&]() {
+  Batch::Rotate(rotationStream, pointStream, resultStream);
+  DoNotOptimize(resultStream.x.data());
+});
+env.Measure("rotate_vectors_soa_threaded", count, [&]() {
+  Batch::Rotate(rotationStream, pointStream, resultStream, pool);
+  DoNotOptimize(resultStream.x.data());
+});
+
+END_BENCHMARK() // maths_batch
+
+BEGIN_BENCHMARK(maths)
+
+RUN_BENCHMARK(maths_matrices)
+RUN_BENCHMARK(maths_quaternions)
+RUN_BENCHMARK(maths_batch)
+
+END_BENCHMARK() // maths
+
+} // namespace Engine::Test
@@ -2,6 +2,8 @@
 
 #include "Test.h"
 
+#include "Maths/Batch.h"
+#include "Maths/Matrix3x4.h"
 #include "Maths/Transformations.h"
 
 #include "glm/gtx/transform.hpp"
@@ -162,12 +164,299 @@ TEST_ASSERT_EQUAL(float, pp, "direct", pqr, "indirect",
 
 END_TEST_CASE() // quaternion
 
+BEGIN_TEST_CASE(affine)
+
+// Reference results come from the equivalent 4x4 matrices
+Quaternion q = Transformations::RotateAroundAxis(Vector3{0.73059, 1.19045, 0.55717}.Normalized(), 1.3f);
+Quaternion r = Transformations::RotateAroundAxis(Vector3{0.73404, 0.95724, 0.69343}.Normalized(), -0.32f);
+Vector3 position{1.5, -2, 0.25}, scale{2, 0.5, 3};
+Matrix3x4 a = Matrix3x4::FromTRS(position, q, scale);
+Matrix3x4 b = Matrix3x4::FromTRS({-0.75, 4, 1}, r, {1, 1.5, 0.8});
+
+Matrix3 R = q.RotationMatrix();
+Matrix4 T{1, 0, 0, position[X], 0, 1, 0, position[Y], 0, 0, 1, position[Z], 0, 0, 0, 1};
+Matrix4 S{scale[X], 0, 0, 0, 0, scale[Y], 0, 0, 0, 0, scale[Z], 0, 0, 0, 0, 1};
+Matrix4 RS{R[0][0], R[0][1], R[0][2], 0, R[1][0], R[1][1], R[1][2], 0, R[2][0], R[2][1], R[2][2], 0, 0, 0, 0, 1};
+Matrix4 trs = T * RS * S;
+Matrix4 a4 = a.ToMatrix4();
+TEST_ASSERT_EQUAL(float, a4, "affine", trs, "4x4", "Affine TRS matrix differs from translation * rotation * scale!")
+
+// The product of two TRS matrices with non-uniform scales is sheared
+Matrix3x4 ab = a * b;
+Matrix4 ab4 = ab.ToMatrix4(), ab4Expected = a4 * b.ToMatrix4();
+TEST_ASSERT_EQUAL(float, ab4, "affine", ab4Expected, "4x4", "Affine composition is incorrect!")
+
+Vector4 point{3.71460, 12.14657, 3.76972, 1};
+Vector3 transformed = ab.TransformPoint(point.xyz());
+Vector4 transformed4{transformed[X], transformed[Y], transformed[Z], 1}, transformed4Expected = ab4 * point;
+TEST_ASSERT_EQUAL(float, transformed4, "affine", transformed4Expected, "4x4", "Affine point transform is incorrect!")
+
+Matrix4 inverseTRS = a.InverseTRS().ToMatrix4(), inverse = ab.Inverse().ToMatrix4();
+Matrix4 inverseTRSExpected = a4.Inverse(), inverseExpected = ab4.Inverse();
+TEST_ASSERT_EQUAL(float, inverseTRS, "affine", inverseTRSExpected, "4x4", "Affine TRS inverse is incorrect!")
+TEST_ASSERT_EQUAL(float, inverse, "affine", inverseExpected, "4x4", "Affine inverse is incorrect!")
+
+// Normal matrices are the transposed inverses of the linear parts. Entries are copied out, as the padding of Matrix3
+// is not initialised.
+auto entries = [](Matrix3 const &m, bool transpose) {
+  std::array<float, 9> result{};
+  for (uint8_t i = 0; i < 3; i++) {
+    for (uint8_t j = 0; j < 3; j++) {
+      result[i * 3 + j] = transpose ? m[j][i] : m[i][j];
+    }
+  }
+  return result;
+};
+auto normals = entries(ab.NormalMatrix(), false), normalsTRS = entries(a.NormalMatrixTRS(), false);
+auto normalsExpected = entries(ab.Linear().Inverse(), true), normalsTRSExpected = entries(a.Linear().Inverse(), true);
+TEST_ASSERT_EQUAL(float, normals, "affine", normalsExpected, "3x3", "Normal matrix is incorrect!")
+TEST_ASSERT_EQUAL(float, normalsTRS, "affine", normalsTRSExpected, "3x3", "TRS normal matrix is incorrect!")
+
+END_TEST_CASE() // affine
+
+BEGIN_TEST_CASE(simd)
+
+// With MATHS_SIMD, the float 4x4 operations run on the SIMD kernels, while double ones always take the scalar path
+using Matrix4d = MatrixT<4, 4, double>;
+auto toDouble = [](Matrix4 const &m) {
+  Matrix4d result{};
+  for (uint8_t i = 0; i < 4; i++) {
+    for (uint8_t j = 0; j < 4; j++) {
+      result[i][j] = m[i][j];
+    }
+  }
+  return result;
+};
+auto toFloat = [](Matrix4d const &m) {
+  Matrix4 result{};
+  for (uint8_t i = 0; i < 4; i++) {
+    for (uint8_t j = 0; j < 4; j++) {
+      result[i][j] = float(m[i][j]);
+    }
+  }
+  return result;
+};
+
+Matrix4 a{0.8f, -0.3f, 0.5f, 1.2f, 0.1f, 1.7f, -0.6f, 0.4f, -0.9f, 0.2f, 1.1f, -0.7f, 0.3f, 0.6f, -0.2f, 1.4f};
+Matrix4 b{1.3f, 0.4f, -0.8f, 0.2f, -0.5f, 0.9f, 0.7f, -1.1f, 0.6f, -0.4f, 1.5f, 0.3f, 0.2f, 1.0f, -0.3f, 0.8f};
+Vector4 v{0.7f, -1.2f, 0.4f, 2.1f}, w{-0.3f, 0.8f, 1.6f, -0.5f};
+
+Matrix4 product = a * b, productExpected = toFloat(toDouble(a) * toDouble(b));
+TEST_ASSERT_EQUAL(float, product, "float", productExpected, "double", "4x4 multiplication differs from the reference!")
+
+Vector4 av = a * v;
+VectorT<4, double> avReference = toDouble(a) * VectorT<4, double>{v[X], v[Y], v[Z], v[W]};
+Vector4 avExpected{float(avReference[X]), float(avReference[Y]), float(avReference[Z]), float(avReference[W])};
+TEST_ASSERT_EQUAL(float, av, "float", avExpected, "double", "Matrix-vector product differs from the reference!")
+
+Matrix4 transposed = a.Transposed(), transposedReference = toFloat(toDouble(a).Transposed()), transposedExpected{};
+for (uint8_t i = 0; i < 4; i++) {
+  for (uint8_t j = 0; j < 4; j++) {
+    transposedExpected[i][j] = a[j][i];
+  }
+}
+TEST_ASSERT_EQUAL(float, transposed, "float", transposedExpected, "expected", "4x4 transpose is incorrect!")
+TEST_ASSERT_EQUAL(float, transposedReference, "double", transposedExpected, "expected", "4x4 transpose is incorrect!")
+
+Matrix4 inverse = a.Inverse(), inverseExpected = toFloat(toDouble(a).Inverse());
+TEST_ASSERT_EQUAL(float, inverse, "float", inverseExpected, "double", "4x4 inverse differs from the reference!")
+bool singularThrew = false;
+try {
+  Matrix4::Zero().Inverse();
+} catch (...) {
+  singularThrew = true;
+}
+TEST_ASSERT(singularThrew, "Inverting a singular matrix did not throw!")
+
+double dotExpected = VectorT<4, double>{v[X], v[Y], v[Z], v[W]} * VectorT<4, double>{w[X], w[Y], w[Z], w[W]};
+TEST_ASSERT(std::abs(v * w - dotExpected) < 0.0001, "Dot product differs from the reference!")
+
+// Compared as points, as the padding of Vector3 is not initialised
+Vector3 cross = Vector3{v[X], v[Y], v[Z]}.Cross(Vector3{w[X], w[Y], w[Z]});
+VectorT<3, double> crossReference = VectorT<3, double>{v[X], v[Y], v[Z]}.Cross(VectorT<3, double>{w[X], w[Y], w[Z]});
+Vector4 crossPoint{cross[X], cross[Y], cross[Z], 1};
+Vector4 crossExpected{float(crossReference[X]), float(crossReference[Y]), float(crossReference[Z]), 1};
+TEST_ASSERT_EQUAL(float, crossPoint, "float", crossExpected, "double", "Cross product differs from the reference!")
+
+END_TEST_CASE() // simd
+
+BEGIN_TEST_CASE(batch)
+
+// Several chunks for the thread pool, and a tail behind the last full SIMD register
+size_t count = 2 * BATCH_CHUNK_SIZE + 3;
+Batch::Vector3Array points(count), boxMin(count), boxMax(count);
+std::vector<Matrix3x4> matrices(count);
+for (size_t i = 0; i < count; i++) {
+  float t = float(i) / count;
+  points.Set(i, {std::sin(7 * t) + 0.1f, std::cos(5 * t), t - 0.5f});
+  boxMin.Set(i, points.Get(i) - Vector3{t, 0.5f, 1});
+  boxMax.Set(i, points.Get(i) + Vector3{0.5f, t, 1});
+  Quaternion rotation = Transformations::RotateAroundAxis(Vector3{1, t, -1}, 6 * t);
+  matrices[i] = Matrix3x4::FromTRS({t, -t, 2 * t}, rotation, {1 + t, 2 - t, 0.5f + t});
+}
+
+Util::ThreadPool &pool = Util::ThreadPool::Shared();
+Batch::Vector3Array transformed(count), normalized(count), worldMin(count), worldMax(count);
+std::vector<Matrix3x4> products(count);
+Batch::TransformPoints(matrices[1], points, transformed, &pool);
+Batch::Normalize(points, normalized, &pool);
+Batch::Multiply(matrices, matrices, products, &pool);
+Batch::TransformBoundingBoxes(matrices, {boxMin.Span(), boxMax.Span()}, {worldMin.Span(), worldMax.Span()}, &pool);
+
+// Largest difference to the per-element operations
+auto difference = [](Vector3 const &a, Vector3 const &b) {
+  return std::max({std::abs(a[X] - b[X]), std::abs(a[Y] - b[Y]), std::abs(a[Z] - b[Z])});
+};
+float transformError = 0, normalizeError = 0, multiplyError = 0, boxError = 0;
+for (size_t i = 0; i < count; i++) {
+  transformError = std::max(transformError, difference(transformed.Get(i), matrices[1].TransformPoint(points.Get(i))));
+  normalizeError = std::max(normalizeError, difference(normalized.Get(i), points.Get(i).Normalized()));
+  Matrix3x4 product = matrices[i] * matrices[i];
+  for (int j = 0; j < 12; j++) {
+    multiplyError = std::max(multiplyError, std::abs(products[i].data[j] - product.data[j]));
+  }
+
+  // The box around the transformed corners
+  Vector3 lower{INFINITY, INFINITY, INFINITY}, upper{-INFINITY, -INFINITY, -INFINITY};
+  for (int corner = 0; corner < 8; corner++) {
+    Vector3 p = matrices[i].TransformPoint({corner & 1 ? boxMax.x[i] : boxMin.x[i],
+                                            corner & 2 ? boxMax.y[i] : boxMin.y[i],
+                                            corner & 4 ? boxMax.z[i] : boxMin.z[i]});
+    for (uint8_t k = 0; k < 3; k++) {
+      lower[k] = std::min<float>(lower[k], p[k]);
+      upper[k] = std::max<float>(upper[k], p[k]);
+    }
+  }
+  boxError = std::max({boxError, difference(worldMin.Get(i), lower), difference(worldMax.Get(i), upper)});
+}
+TEST_ASSERT(transformError < 0.0001f, "Batched point transform differs by {}!", transformError)
+TEST_ASSERT(normalizeError < 0.0001f, "Batched normalisation differs by {}!", normalizeError)
+TEST_ASSERT(multiplyError < 0.0001f, "Batched matrix products differ by {}!", multiplyError)
+TEST_ASSERT(boxError < 0.0001f, "Batched bounding boxes differ by {}!", boxError)
+
+END_TEST_CASE() // batch
+
+BEGIN_TEST_CASE(quaternion_batch)
+
+Quaternion a = Transformations::RotateAroundAxis(Vector3{1, 2, -0.5f}.Normalized(), 1.2f);
+Quaternion b = Transformations::RotateAroundAxis(Vector3{-0.3f, 1, 0.8f}.Normalized(), -2.1f);
+Quaternion scaled = a * 3.0f;
+TEST_ASSERT(abs(scaled.Normalized().Length() - 1) < EQUALITY_EPS, "Normalised quaternion has length {}!",
+            scaled.Normalized().Length())
+TEST_ASSERT(abs(Quaternion::Slerp(a, b, 0).Dot(a) - 1) < EQUALITY_EPS, "Slerp does not start at the first rotation!")
+TEST_ASSERT(abs(abs(Quaternion::Slerp(a, b, 1).Dot(b)) - 1) < EQUALITY_EPS,
+            "Slerp does not end at the second rotation!")
+// Halfway, both ends are the same angle away
+Quaternion half = Quaternion::Slerp(a, b, 0.5f);
+TEST_ASSERT(abs(abs(half.Dot(a)) - abs(half.Dot(b))) < EQUALITY_EPS, "Slerp halfway is not between the rotations!")
+
+// Several chunks for the thread pool, and a tail behind the last full SIMD register
+size_t count = 2 * BATCH_CHUNK_SIZE + 3;
+Batch::QuaternionArray p(count), q(count);
+Batch::Vector3Array points(count), positions(count), scales(count);
+for (size_t i = 0; i < count; i++) {
+  float t = float(i) / count;
+  p.Set(i, Transformations::RotateAroundAxis(Vector3{1, t, -1}.Normalized(), 6 * t));
+  // Every other pair on opposite hemispheres, some close enough for Slerp to fall back to Nlerp
+  Quaternion r = Transformations::RotateAroundAxis(Vector3{t, 1, 0.5f}.Normalized(), i % 7 ? -4 * t : 0.01f);
+  q.Set(i, i % 2 ? p.Get(i) * r * -1.0f : p.Get(i) * r);
+  points.Set(i, {std::sin(7 * t) + 0.1f, std::cos(5 * t), t - 0.5f});
+  positions.Set(i, {t, -t, 2 * t});
+  scales.Set(i, {1 + t, 2 - t, 0.5f + t});
+}
+
+Util::ThreadPool &pool = Util::ThreadPool::Shared();
+Batch::QuaternionArray products(count), spun(count), normalized(count), nlerped(count), slerped(count);
+Batch::Vector3Array rotated(count);
+std::vector<Matrix3> rotations(count);
+std::vector<Matrix3x4> locals(count);
+Batch::Multiply(p, q, products, &pool);
+Batch::Multiply(a, p, spun, &pool);
+Batch::Normalize(products, normalized, &pool);
+Batch::Nlerp(p, q, 0.3f, nlerped, &pool);
+Batch::Slerp(p, q, 0.3f, slerped, &pool);
+Batch::RotationMatrices(p, rotations, &pool);
+Batch::FromTRS(positions, p, scales, locals, &pool);
+Batch::Rotate(p, points, rotated, &pool);
+
+// Largest difference to the per-element operations
+auto difference = [](Quaternion const &a, Quaternion const &b) {
+  return std::max({std::abs(a.w - b.w), std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+};
+float multiplyError = 0, normalizeError = 0, nlerpError = 0, slerpError = 0, matrixError = 0, rotateError = 0;
+for (size_t i = 0; i < count; i++) {
+  multiplyError = std::max({multiplyError, difference(products.Get(i), p.Get(i) * q.Get(i)),
+                            difference(spun.Get(i), a * p.Get(i))});
+  normalizeError = std::max(normalizeError, difference(normalized.Get(i), (p.Get(i) * q.Get(i)).Normalized()));
+  nlerpError = std::max(nlerpError, difference(nlerped.Get(i), Quaternion::Nlerp(p.Get(i), q.Get(i), 0.3f)));
+  slerpError = std::max(slerpError, difference(slerped.Get(i), Quaternion::Slerp(p.Get(i), q.Get(i), 0.3f)));
+
+  Matrix3 rotation = p.Get(i).RotationMatrix();
+  Matrix3x4 local = Matrix3x4::FromTRS(positions.Get(i), p.Get(i), scales.Get(i));
+  for (uint8_t j = 0; j < 3; j++) {
+    for (uint8_t k = 0; k < 3; k++) {
+      matrixError = std::max(matrixError, std::abs(rotations[i][j][k] - rotation[j][k]));
+    }
+  }
+  for (int j = 0; j < 12; j++) {
+    matrixError = std::max(matrixError, std::abs(locals[i].data[j] - local.data[j]));
+  }
+
+  Vector3 expected = Transformations::RotateByQuaternion(points.Get(i), p.Get(i)), actual = rotated.Get(i);
+  for (uint8_t k = 0; k < 3; k++) {
+    rotateError = std::max(rotateError, std::abs(actual[k] - expected[k]));
+  }
+}
+TEST_ASSERT(multiplyError < 0.0001f, "Batched quaternion products differ by {}!", multiplyError)
+TEST_ASSERT(normalizeError < 0.0001f, "Batched quaternion normalisation differs by {}!", normalizeError)
+TEST_ASSERT(nlerpError < 0.0001f, "Batched nlerp differs by {}!", nlerpError)
+TEST_ASSERT(slerpError < 0.0001f, "Batched slerp differs by {}!", slerpError)
+TEST_ASSERT(matrixError < 0.0001f, "Batched rotation matrices differ by {}!", matrixError)
+TEST_ASSERT(rotateError < 0.0001f, "Batched vector rotation differs by {}!", rotateError)
+
+END_TEST_CASE() // quaternion_batch
+
+BEGIN_TEST_CASE(expression)
+
+// Constant matrices are built at compile time, in the same column form as at runtime
+constexpr Matrix3 constant{1, 2, 3, 4, 5, 6, 7, 8, 9};
+static_assert(constant[0][1] == 4 && constant[2][0] == 3, "Constant matrix is not in column form!");
+static_assert(constant.Transposed()[0][1] == 2, "Constant transpose is incorrect!");
+static_assert((constant * Matrix3::Identity())[1][2] == 8, "Constant product is incorrect!");
+static_assert((Matrix4::Identity() * Matrix4::Identity())[3][3] == 1, "Constant 4x4 product is incorrect!");
+
+constexpr Vector3 a{1, 2, 3}, b{4, 5, 6};
+static_assert(Vector3(a + b * 2.0f - 1.0f)[Z] == 14, "Constant vector expression is incorrect!");
+static_assert(a * b == 32 && a.Cross(b)[X] == -3, "Constant vector products are incorrect!");
+
+// Element-wise chains are evaluated once assigned
+Vector3 c{7, 8, 9};
+Vector3 chain = a + b * 2.0f - c / 2.0f + 1.0f;
+TEST_ASSERT(chain == Vector3(6.5f, 9.0f, 11.5f), "Vector expression gives {}!", chain)
+auto sum = Vector3{1, 1, 1} + a; // Keeps a copy of the temporary
+TEST_ASSERT(Vector3(sum) == Vector3(2, 3, 4), "Stored vector expression gives {}!", Vector3(sum))
+TEST_ASSERT(abs((a + b) * a - 46) < EQUALITY_EPS, "Dot product of an expression gives {}!", (a + b) * a)
+TEST_ASSERT(constant * (b - a) == Vector3(18, 45, 72), "Matrix-expression product is incorrect!")
+TEST_ASSERT(abs((c - a).Normalized().Length() - 1) < EQUALITY_EPS, "Normalized expression has the wrong length!")
+
+Vector3 p = a;
+p += b * 2.0f;
+p -= p * 0.5f; // Reads p while writing it, element by element
+TEST_ASSERT(p == Vector3(4.5f, 6.0f, 7.5f), "Compound assignment of an expression gives {}!", p)
+
+END_TEST_CASE() // expression
+
 BEGIN_TEST_CASE(maths)
 
 RUN_SUB_CASE(vector)
 RUN_SUB_CASE(matrix)
 RUN_SUB_CASE(transformation)
 RUN_SUB_CASE(quaternion)
+RUN_SUB_CASE(affine)
+RUN_SUB_CASE(simd)
+RUN_SUB_CASE(batch)
+RUN_SUB_CASE(quaternion_batch)
+RUN_SUB_CASE(expression)
 
 END_TEST_CASE() // maths
 } // namespace Engine::Test
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include "Core/ECS.h"
+#include "Core/SceneHierarchy.h"
+#include "Graphics/Transform.h"
+
+#include <format>
+#include <memory>
+
+using Engine::Graphics::Transform;
+
+namespace Engine::Test {
+
+inline constexpr uint32_t TRANSFORM_BENCHMARK_COUNTS[] = {1 << 12, 100000};
+
+// Tree with eight children per node, so that 100k transforms make six levels
+inline std::unique_ptr<Core::ECS> MakeTransformTree(uint32_t count, bool flattened) {
+  auto ecs = std::make_unique<Core::ECS>();
+  if (flattened) {
+    ecs->EmplaceResource<Core::SceneHierarchy>(ecs.get());
+  }
+  std::vector<Core::Entity> entities{};
+  entities.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    Core::Entity e = ecs->CreateEntity();
+    e.AddComponent<Transform>()->position = Vector3{float(i % 8), 1, 0};
+    if (i > 0) {
+      e.GetComponent<Core::HierarchyComponent>()->SetParent(
+          entities[(i - 1) / 8].GetComponent<Core::HierarchyComponent>());
+    }
+    entities.push_back(e);
+  }
+  return ecs;
+}
+
+BEGIN_BENCHMARK(transform_propagation)
+
+Core::ECS::RegisterComponent<Core::HierarchyComponent>();
+Core::ECS::RegisterComponent<Transform>();
+
+for (uint32_t count : TRANSFORM_BENCHMARK_COUNTS) {
+  for (bool flattened : {false, true}) {
+    std::unique_ptr<Core::ECS> ecs = MakeTransformTree(count, flattened);
+    Core::Entity root = *ecs->begin();
+    Transform::UpdateWorldMatrices(ecs.get()); // Flattens the hierarchy outside of the measurement
+    // Moving the root outdates every world matrix
+    env.Measure(
+        std::format("{} {}", flattened ? "update_levels" : "update_lazy", count), count,
+        [&]() { root.ModifyComponent<Transform>()->position += Vector3{0, 0, 1}; },
+        [&]() { Transform::UpdateWorldMatrices(ecs.get()); });
+  }
+}
+
+END_BENCHMARK() // transform_propagation
+
+BEGIN_BENCHMARK(transforms)
+
+RUN_BENCHMARK(transform_propagation)
+
+END_BENCHMARK() // transforms
+
+} // namespace Engine::Test
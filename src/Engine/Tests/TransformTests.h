@@ -0,0 +1,271 @@
+#pragma once
+
+#include "Test.h"
+
+#include "Core/ECS.h"
+#include "Core/HierarchyComponent.h"
+#include "Core/SceneHierarchy.h"
+#include "Graphics/Transform.h"
+
+using namespace Engine::Core;
+using Engine::Graphics::Transform;
+
+namespace Engine::Test {
+
+BEGIN_TEST_CASE(transform_caching)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<Transform>();
+
+ECS ecs{};
+std::vector<Entity> chain{};
+for (int i = 0; i < 5; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<Transform>();
+  if (i > 0) {
+    e.GetComponent<HierarchyComponent>()->SetParent(chain.back().GetComponent<HierarchyComponent>());
+  }
+  Transform *transform = e.ModifyComponent<Transform>();
+  transform->position = Vector3{float(i + 1), 0, 0};
+  transform->rotation = Transformations::RotateAroundAxis(Vector3{0, 1, 0}, 0.5f);
+  transform->scale = Vector3{1, 2, 1};
+  chain.push_back(e);
+}
+
+Matrix4 expected = Matrix4::Identity();
+Quaternion expectedRotation = Quaternion::Identity();
+for (auto const &e : chain) {
+  expected = expected * e.GetComponent<Transform>()->ModelToParentMatrix();
+  expectedRotation = expectedRotation * e.GetComponent<Transform>()->rotation;
+}
+Matrix4 leafMatrix = chain.back().GetComponent<Transform>()->ModelToWorldMatrix();
+Quaternion leafRotation = chain.back().GetComponent<Transform>()->WorldRotation();
+TEST_ASSERT_EQUAL(float, leafMatrix, "cached", expected, "expected", "Cached world matrix is wrong!")
+TEST_ASSERT_EQUAL(float, leafRotation, "cached", expectedRotation, "expected", "Cached world rotation is wrong!")
+
+// Moving the root has to reach the leaf, whose matrix is cached by now. Positions are compared as points, as the
+// padding of Vector3 is not initialised.
+auto point = [](Vector3 const &p) { return Vector4{p[X], p[Y], p[Z], 1}; };
+Vector4 leafPosition = point(chain.back().GetComponent<Transform>()->WorldPosition());
+chain.front().ModifyComponent<Transform>()->position += Vector3{0, 5, 0};
+Transform::UpdateWorldMatrices(&ecs);
+Vector4 movedPosition = point(chain.back().GetComponent<Transform>()->WorldPosition());
+Vector4 expectedPosition = leafPosition + Vector4{0, 5, 0, 0};
+TEST_ASSERT_EQUAL(float, movedPosition, "cached", expectedPosition, "expected",
+                  "Change of the root did not reach the leaf!")
+Vector4 leafOrigin = expected * Vector4{0, 0, 0, 1};
+TEST_ASSERT_EQUAL(float, leafPosition, "world position", leafOrigin, "origin",
+                  "World position is not the origin of the model!")
+
+// Reparenting keeps the world position
+Entity attached = ecs.CreateEntity();
+attached.AddComponent<Transform>();
+attached.ModifyComponent<Transform>()->position = Vector3{1, 2, 3};
+attached.GetComponent<HierarchyComponent>()->SetParent(chain[2].GetComponent<HierarchyComponent>());
+Vector4 attachedPosition = point(attached.GetComponent<Transform>()->WorldPosition());
+Vector4 originalPosition{1, 2, 3, 1};
+TEST_ASSERT_EQUAL(float, attachedPosition, "reparented", originalPosition, "original",
+                  "Reparenting moved the transform!")
+
+// Detaching makes the transform a root and keeps the world position as well
+attached.GetComponent<HierarchyComponent>()->SetParent(nullptr);
+Vector4 detachedPosition = point(attached.GetComponent<Transform>()->WorldPosition());
+TEST_ASSERT(!attached.GetComponent<Transform>()->Parent(), "Detached transform kept its parent!")
+TEST_ASSERT_EQUAL(float, detachedPosition, "detached", originalPosition, "original", "Detaching moved the transform!")
+
+END_TEST_CASE() // transform_caching
+
+BEGIN_TEST_CASE(transform_levels)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<Transform>();
+
+// Wide enough for the levels to be split into several chunks
+ECS ecs{};
+SceneHierarchy *hierarchy = ecs.EmplaceResource<SceneHierarchy>(&ecs);
+std::vector<Entity> entities{};
+for (int i = 0; i < 4000; i++) {
+  Entity e = ecs.CreateEntity();
+  e.AddComponent<Transform>();
+  if (i > 0) {
+    e.GetComponent<HierarchyComponent>()->SetParent(entities[(i - 1) / 8].GetComponent<HierarchyComponent>());
+  }
+  Transform *transform = e.ModifyComponent<Transform>();
+  transform->position = Vector3{float(i % 8), 1, 0};
+  transform->rotation = Transformations::RotateAroundAxis(Vector3{0, 0, 1}, 0.01f * float(i % 8));
+  entities.push_back(e);
+}
+
+auto const &flattened = hierarchy->Flatten();
+bool parentsFirst = flattened.entities.size() == entities.size() && flattened.LevelCount() == 5;
+for (size_t level = 0; level < flattened.LevelCount(); level++) {
+  for (size_t i = flattened.LevelBegin(level); i < flattened.LevelEnd(level); i++) {
+    uint32_t parentIndex = flattened.parents[i];
+    parentsFirst &= level == 0 ? parentIndex == flattened.NO_PARENT : parentIndex < flattened.LevelBegin(level);
+  }
+}
+TEST_ASSERT(parentsFirst, "Flattened hierarchy is not sorted by depth!")
+
+entities[0].ModifyComponent<Transform>()->position += Vector3{0, 0, 3};
+entities[5].ModifyComponent<Transform>()->scale = Vector3{2, 2, 2};
+Transform::UpdateWorldMatrices(&ecs);
+bool matching = true;
+for (int i : {1, 5, 41, 329, 3999}) {
+  Matrix4 expected = Matrix4::Identity();
+  for (int j = i; j > 0; j = (j - 1) / 8) {
+    expected = entities[j].GetComponent<Transform>()->ModelToParentMatrix() * expected;
+  }
+  expected = entities[0].GetComponent<Transform>()->ModelToParentMatrix() * expected;
+  Matrix4 updated = entities[i].GetComponent<Transform>()->ModelToWorldMatrix();
+  for (int column = 0; column < 4; column++) {
+    for (int row = 0; row < 4; row++) {
+      matching &= std::abs(updated[column][row] - expected[column][row]) < 0.001f;
+    }
+  }
+}
+TEST_ASSERT(matching, "Level by level update computed wrong world matrices!")
+
+END_TEST_CASE() // transform_levels
+
+BEGIN_TEST_CASE(transform_batch_matches_lazy)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<Transform>();
+
+// The same nested hierarchy, once with a SceneHierarchy for the level by level update and once without, where every
+// world matrix is computed lazily. Entity 3 has no Transform, so its children are roots for both paths.
+auto build = [](ECS &ecs) {
+  std::vector<Entity> entities{};
+  for (int i = 0; i < 12; i++) {
+    Entity e = ecs.CreateEntity();
+    if (i == 3) {
+      e.AddComponent<HierarchyComponent>();
+    } else {
+      e.AddComponent<Transform>();
+    }
+    if (i > 0) {
+      e.GetComponent<HierarchyComponent>()->SetParent(entities[(i - 1) / 2].GetComponent<HierarchyComponent>());
+    }
+    if (i != 3) {
+      Transform *transform = e.ModifyComponent<Transform>();
+      transform->position = Vector3{float(i), 1, float(i % 3)};
+      transform->rotation = Transformations::RotateAroundAxis(Vector3{0, 1, 0}, 0.2f * float(i));
+      transform->scale = Vector3{1, 1 + 0.1f * float(i), 1};
+    }
+    entities.push_back(e);
+  }
+  // Moving a subtree and detaching an entity after the first update
+  Transform::UpdateWorldMatrices(&ecs);
+  entities[4].GetComponent<HierarchyComponent>()->SetParent(entities[5].GetComponent<HierarchyComponent>());
+  entities[6].GetComponent<HierarchyComponent>()->SetParent(nullptr);
+  entities[0].ModifyComponent<Transform>()->position += Vector3{0, 2, 0};
+  Transform::UpdateWorldMatrices(&ecs);
+  return entities;
+};
+ECS batchECS{};
+batchECS.EmplaceResource<SceneHierarchy>(&batchECS);
+ECS lazyECS{};
+std::vector<Entity> batched = build(batchECS);
+std::vector<Entity> lazy = build(lazyECS);
+
+bool matching = true;
+for (size_t i = 0; i < batched.size(); i++) {
+  if (!batched[i].HasComponent<Transform>()) {
+    continue;
+  }
+  Matrix4 batchMatrix = batched[i].GetComponent<Transform>()->ModelToWorldMatrix();
+  Matrix4 lazyMatrix = lazy[i].GetComponent<Transform>()->ModelToWorldMatrix();
+  for (int column = 0; column < 4; column++) {
+    for (int row = 0; row < 4; row++) {
+      matching &= std::abs(batchMatrix[column][row] - lazyMatrix[column][row]) < 0.001f;
+    }
+  }
+}
+TEST_ASSERT(matching, "Level by level update and lazy evaluation disagree on world matrices!")
+
+END_TEST_CASE() // transform_batch_matches_lazy
+
+BEGIN_TEST_CASE(transform_parent_removal)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<Transform>();
+
+// Once the parent is destroyed or loses its Transform, the child's cached world matrix must not include it anymore.
+// Checked with the level by level update (SceneHierarchy) and with lazy evaluation.
+for (bool destroy : {true, false}) {
+  for (bool levels : {true, false}) {
+    ECS ecs{};
+    if (levels) {
+      ecs.EmplaceResource<SceneHierarchy>(&ecs);
+    }
+    Entity parent = ecs.CreateEntity();
+    parent.AddComponent<Transform>()->position = Vector3{10, 0, 0};
+    Entity child = ecs.CreateEntity();
+    child.AddComponent<Transform>();
+    child.GetComponent<HierarchyComponent>()->SetParent(parent.GetComponent<HierarchyComponent>());
+    child.ModifyComponent<Transform>()->position = Vector3::Zero(); // Reparenting kept the world position
+    Transform::UpdateWorldMatrices(&ecs);
+    float attachedX = child.GetComponent<Transform>()->WorldPosition()[X];
+
+    if (destroy) {
+      parent.Destroy();
+    } else {
+      parent.RemoveComponent<Transform>();
+    }
+    Transform::UpdateWorldMatrices(&ecs);
+    float detachedX = child.GetComponent<Transform>()->WorldPosition()[X];
+    TEST_ASSERT(attachedX == 10 && detachedX == 0, "Child is at x={} after its parent {} (levels: {})!", detachedX,
+                destroy ? "was destroyed" : "lost its Transform", levels)
+  }
+}
+
+END_TEST_CASE() // transform_parent_removal
+
+BEGIN_TEST_CASE(transform_prefabs)
+
+ECS::RegisterComponent<HierarchyComponent>();
+ECS::RegisterComponent<Transform>();
+
+// Built like EntityConverter::ConvertDSO, which assigns the hierarchy parent directly
+ECS prefabs{};
+Entity root = prefabs.CreateEntity();
+root.AddComponent<Transform>();
+root.GetComponent<Transform>()->position = Vector3{1, 0, 0};
+root.GetComponent<Transform>()->rotation = Transformations::RotateAroundAxis(Vector3{0, 0, 1}, 0.5f);
+Entity child = prefabs.CreateEntity();
+child.AddComponent<Transform>();
+child.GetComponent<Transform>()->position = Vector3{0, 2, 0};
+root.GetComponent<HierarchyComponent>()->children.push_back(child);
+child.GetComponent<HierarchyComponent>()->parent = root;
+child.NotifyParentChange();
+
+auto point = [](Vector3 const &p) { return Vector4{p[X], p[Y], p[Z], 1}; };
+Vector4 expected = root.GetComponent<Transform>()->ModelToParentMatrix() * Vector4{0, 2, 0, 1};
+
+// Loading a scene clones its pattern
+ECS loaded{};
+loaded.Copy(&prefabs);
+Vector4 loadedPosition = point(child.InOtherECS(&loaded).GetComponent<Transform>()->WorldPosition());
+TEST_ASSERT_EQUAL(float, loadedPosition, "loaded", expected, "expected", "Loaded child is not moved by its parent!")
+
+// Instantiating a prefab copies entity by entity
+ECS instances{};
+Entity instance = root.CopyToOtherECS(&instances);
+Entity instanceChild = instance.GetComponent<HierarchyComponent>()->children[0];
+Vector4 instancePosition = point(instanceChild.GetComponent<Transform>()->WorldPosition());
+TEST_ASSERT_EQUAL(float, instancePosition, "instance", expected, "expected",
+                  "Child of a prefab instance is not moved by its parent!")
+
+END_TEST_CASE() // transform_prefabs
+
+BEGIN_TEST_CASE(transforms)
+
+RUN_SUB_CASE(transform_caching)
+RUN_SUB_CASE(transform_levels)
+RUN_SUB_CASE(transform_batch_matches_lazy)
+RUN_SUB_CASE(transform_parent_removal)
+RUN_SUB_CASE(transform_prefabs)
+
+END_TEST_CASE() // transforms
+
+} // namespace Engine::Test
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+#define CACHE_LINE_SIZE 64
+
+namespace Engine::Util {
+
+// Allocator for std containers whose storage has to start on a cache line (or any larger power of two)
+template <typename T, size_t alignment = CACHE_LINE_SIZE> struct AlignedAllocator {
+  using value_type = T;
+  template <typename U> struct rebind {
+    using other = AlignedAllocator<U, alignment>;
+  };
+
+  static constexpr std::align_val_t ALIGNMENT = std::align_val_t(std::max(alignment, alignof(T)));
+
+  AlignedAllocator() = default;
+  template <typename U> AlignedAllocator(AlignedAllocator<U, alignment> const &) {}
+
+  inline T *allocate(size_t count) { return static_cast<T *>(::operator new(count * sizeof(T), ALIGNMENT)); }
+  inline void deallocate(T *pointer, size_t count) { ::operator delete(pointer, count * sizeof(T), ALIGNMENT); }
+
+  template <typename U> inline bool operator==(AlignedAllocator<U, alignment> const &) const { return true; }
+  template <typename U> inline bool operator!=(AlignedAllocator<U, alignment> const &) const { return false; }
+};
+
+} // namespace Engine::Util
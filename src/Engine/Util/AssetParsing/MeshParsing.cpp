@@ -2,6 +2,7 @@
 
 #include "Debug/Logging.h"
 #include "Debug/Profiling.h"
+#include "Maths/Batch.h"
 
 namespace Engine {
 
@@ -291,7 +292,9 @@ inline Graphics::Mesh CalculateTangentSpace(Graphics::MeshT<OBJVertex> &objMesh)
   std::vector<Maths::Vector3> cotangents(objMesh.vertices.size(), Maths::Vector3({0, 0, 0}));
   std::vector<Maths::Vector3> cobitangents(objMesh.vertices.size(), Maths::Vector3({0, 0, 0}));
 
-  for (int i = 0; i < objMesh.indices.size(); i += 3) {
+  // Tangents and bitangents of the triangles, normalised as a batch before they are accumulated per vertex
+  Maths::Batch::Vector3Array tangents(objMesh.indices.size() / 3), bitangents(objMesh.indices.size() / 3);
+  for (int i = 0; i + 2 < objMesh.indices.size(); i += 3) {
 
     auto i0 = objMesh.indices[i];
     auto i1 = objMesh.indices[i + 1];
@@ -309,15 +312,17 @@ inline Graphics::Mesh CalculateTangentSpace(Graphics::MeshT<OBJVertex> &objMesh)
     Maths::Matrix3 mat = Maths::Matrix3(q1[X], q1[Y], q1[Z], q2[X], q2[Y], q2[Z], N[X], N[Y], N[Z]);
     Maths::Matrix3 invMat = mat.Inverse();
 
-    Maths::Matrix3 test = mat * invMat;
-
-    Maths::Vector3 T = (invMat * Maths::Vector3(objMesh.vertices[i1].uv[X] - objMesh.vertices[i0].uv[X],
-                                                objMesh.vertices[i2].uv[X] - objMesh.vertices[i0].uv[X], 0))
-                           .Normalized();
-    Maths::Vector3 B = (invMat * Maths::Vector3(objMesh.vertices[i1].uv[Y] - objMesh.vertices[i0].uv[Y],
-                                                objMesh.vertices[i2].uv[Y] - objMesh.vertices[i0].uv[Y], 0))
-                           .Normalized();
+    tangents.Set(i / 3, invMat * Maths::Vector3(objMesh.vertices[i1].uv[X] - objMesh.vertices[i0].uv[X],
+                                                objMesh.vertices[i2].uv[X] - objMesh.vertices[i0].uv[X], 0));
+    bitangents.Set(i / 3, invMat * Maths::Vector3(objMesh.vertices[i1].uv[Y] - objMesh.vertices[i0].uv[Y],
+                                                  objMesh.vertices[i2].uv[Y] - objMesh.vertices[i0].uv[Y], 0));
+  }
+  Maths::Batch::Normalize(tangents, tangents, &Util::ThreadPool::Shared());
+  Maths::Batch::Normalize(bitangents, bitangents, &Util::ThreadPool::Shared());
 
+  for (int i = 0; i + 2 < objMesh.indices.size(); i += 3) {
+    Maths::Vector3 T = tangents.Get(i / 3);
+    Maths::Vector3 B = bitangents.Get(i / 3);
     for (int j = 0; j < 3; j++) {
       triangleParticipations[objMesh.indices[i + j]]++;
       cotangents[objMesh.indices[i + j]] += T;
@@ -24,9 +24,9 @@ Core::Entity EntityConverter::ConvertDSO(ExplicitEntityDSO const &dso) const {
   Core::Entity entity = ecs->CreateEntity();
   for (auto component : dso.components) {
     if (auto hierarchyDSO = dynamic_cast<HierarchyDSO *>(component)) {
-      auto hierarchy = entity.HasComponent<Core::HierarchyComponent>()
-                           ? entity.GetComponent<Core::HierarchyComponent>()
-                           : entity.AddComponent<Core::HierarchyComponent>();
+      if (!entity.HasComponent<Core::HierarchyComponent>()) {
+        entity.AddComponent<Core::HierarchyComponent>();
+      }
       for (auto &childDSO : hierarchyDSO->children) {
         Core::Entity child{};
         if (auto prefabDSO = dynamic_cast<PrefabDSO *>(childDSO)) {
@@ -37,9 +37,10 @@ Core::Entity EntityConverter::ConvertDSO(ExplicitEntityDSO const &dso) const {
         if (!child.HasComponent<Core::HierarchyComponent>()) {
           child.AddComponent<Core::HierarchyComponent>();
         }
-        auto childHierarchy = child.GetComponent<Core::HierarchyComponent>();
-        hierarchy->children.push_back(childHierarchy);
-        childHierarchy->parent = hierarchy;
+        // Converting the child may have relocated the parent's HierarchyComponent, so it is looked up again
+        entity.GetComponent<Core::HierarchyComponent>()->children.push_back(child);
+        child.GetComponent<Core::HierarchyComponent>()->parent = entity;
+        child.NotifyParentChange(); // The child is no longer a root of the SceneHierarchy
       }
     } else {
       component->AttachToEntity(entity, assetManager);
@@ -76,7 +77,6 @@ Core::Scene *SceneConverter::ConvertDSO(SceneDSO const &dso) const {
       scene->mainCamera = entity;
     }
   }
-  scene->sceneHierarchy.Rebuild();
   return scene;
 }
 
@@ -86,13 +86,7 @@ Core::Scene *SceneCache::LoadAsset(char const *assetName) const {
   auto pattern = baseCache.LoadAsset(assetName);
   auto copy = new Core::Scene();
   copy->ecs.Copy(&pattern->ecs);
-  copy->sceneHierarchy.Rebuild();
-  copy->mainCamera = pattern->mainCamera.InOtherECS(&copy->ecs);
-  for (auto &[transform] : copy->ecs.FilterEntities<Graphics::Transform>()) {
-    if (transform->hierarchy->parent) {
-      transform->parent = transform->hierarchy->parent->entity.GetComponent<Graphics::Transform>();
-    }
-  }
+  copy->mainCamera = pattern->mainCamera.InOtherECS(&copy->ecs); // The copy is a clone, so handles carry over
   return copy;
 }
 
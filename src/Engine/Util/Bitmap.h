@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <inttypes.h>
+#include <span>
+#include <vector>
+
+namespace Engine::Util {
+
+// Growable bit set over indices. Scans load 64 bits at a time and jump straight to set bits with countr_zero, so runs
+// of cleared bits cost one load per 64 indices.
+class Bitmap {
+  std::vector<uint64_t> words;
+
+public:
+  Bitmap() : words() {}
+
+  inline bool Test(size_t index) const {
+    size_t word = index >> 6;
+    return word < words.size() && ((words[word] >> (index & 63)) & 1);
+  }
+  inline void Set(size_t index) {
+    size_t word = index >> 6;
+    if (word >= words.size()) {
+      words.resize(std::max(word + 1, 2 * words.size()), 0);
+    }
+    words[word] |= uint64_t(1) << (index & 63);
+  }
+  inline void Clear(size_t index) {
+    size_t word = index >> 6;
+    if (word < words.size()) {
+      words[word] &= ~(uint64_t(1) << (index & 63));
+    }
+  }
+
+  // First set index in [from, end), end if there is none
+  inline size_t FindNext(size_t from, size_t end) const {
+    size_t word = from >> 6;
+    if (from >= end || word >= words.size()) {
+      return end;
+    }
+    uint64_t bits = words[word] & (~uint64_t(0) << (from & 63));
+    while (!bits) {
+      if (++word >= words.size() || 64 * word >= end) {
+        return end;
+      }
+      bits = words[word];
+    }
+    return std::min<size_t>(64 * word + std::countr_zero(bits), end);
+  }
+
+  // Calls fn(index) for every set index in increasing order
+  template <typename Fn> inline void ForEachSet(Fn const &fn) const {
+    for (size_t word = 0; word < words.size(); word++) {
+      for (uint64_t bits = words[word]; bits; bits &= bits - 1) {
+        fn(64 * word + std::countr_zero(bits));
+      }
+    }
+  }
+
+  // Calls fn(index) in increasing order for every index that is set in all bitmaps
+  template <typename Fn> static inline void ForEachSetInAll(std::span<Bitmap const *const> bitmaps, Fn const &fn) {
+    if (bitmaps.empty()) {
+      return;
+    }
+    size_t wordCount = bitmaps[0]->words.size();
+    for (Bitmap const *bitmap : bitmaps) {
+      wordCount = std::min(wordCount, bitmap->words.size());
+    }
+    for (size_t word = 0; word < wordCount; word++) {
+      uint64_t bits = bitmaps[0]->words[word];
+      for (size_t i = 1; bits && i < bitmaps.size(); i++) {
+        bits &= bitmaps[i]->words[word];
+      }
+      for (; bits; bits &= bits - 1) {
+        fn(64 * word + std::countr_zero(bits));
+      }
+    }
+  }
+
+  inline size_t Count() const {
+    size_t count = 0;
+    for (uint64_t word : words) {
+      count += std::popcount(word);
+    }
+    return count;
+  }
+
+  inline size_t MemoryUsage() const { return words.capacity() * sizeof(uint64_t); }
+};
+
+} // namespace Engine::Util
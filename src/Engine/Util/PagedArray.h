@@ -0,0 +1,63 @@
+#pragma once
+
+#include <inttypes.h>
+#include <memory>
+#include <vector>
+
+namespace Engine::Util {
+
+// Sparse array that only allocates pages of 2^pageBits entries for index ranges in use. Every entry that is written
+// has to be acquired first; a page is freed again once all of its entries have been released.
+template <typename T, size_t pageBits> class PagedArray {
+  static constexpr size_t PAGE_SIZE = size_t(1) << pageBits;
+  static constexpr size_t PAGE_MASK = PAGE_SIZE - 1;
+
+  struct Page {
+    T entries[PAGE_SIZE];
+    size_t usedEntries = 0;
+  };
+
+  std::vector<std::unique_ptr<Page>> pages;
+  size_t allocatedPages = 0;
+
+public:
+  PagedArray() : pages(), allocatedPages(0) {}
+  PagedArray(PagedArray const &other) : pages(other.pages.size()), allocatedPages(other.allocatedPages) {
+    for (size_t page = 0; page < pages.size(); page++) {
+      if (other.pages[page]) {
+        pages[page] = std::make_unique<Page>(*other.pages[page]);
+      }
+    }
+  }
+
+  // Only valid for acquired entries
+  inline T &operator[](size_t index) { return pages[index >> pageBits]->entries[index & PAGE_MASK]; }
+  inline T const &operator[](size_t index) const { return pages[index >> pageBits]->entries[index & PAGE_MASK]; }
+
+  inline T &Acquire(size_t index) {
+    size_t page = index >> pageBits;
+    if (page >= pages.size()) {
+      pages.resize(page + 1);
+    }
+    if (!pages[page]) {
+      pages[page] = std::make_unique<Page>();
+      allocatedPages++;
+    }
+    pages[page]->usedEntries++;
+    return pages[page]->entries[index & PAGE_MASK];
+  }
+
+  inline void Release(size_t index) {
+    size_t page = index >> pageBits;
+    if (--pages[page]->usedEntries == 0) {
+      pages[page].reset();
+      allocatedPages--;
+    }
+  }
+
+  inline size_t MemoryUsage() const {
+    return allocatedPages * sizeof(Page) + pages.capacity() * sizeof(std::unique_ptr<Page>);
+  }
+};
+
+} // namespace Engine::Util
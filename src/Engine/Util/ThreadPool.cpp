@@ -0,0 +1,84 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace Engine::Util {
+
+ThreadPool::ThreadPool(size_t workerCount) : workers(), batches(), mutex(), stopping(false) {
+  workers.reserve(workerCount);
+  for (size_t i = 0; i < workerCount; i++) {
+    workers.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::DefaultWorkerCount() {
+  // The dispatching thread takes part in the work, so it does not need a worker of its own
+  return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+}
+
+ThreadPool &ThreadPool::Shared() {
+  static ThreadPool sharedPool{};
+  return sharedPool;
+}
+
+void ThreadPool::WorkOn(std::shared_ptr<Batch> const &batch) {
+  size_t index;
+  while ((index = batch->next.fetch_add(1)) < batch->count) {
+    batch->invoke(batch->job, index);
+    if (batch->finished.fetch_add(1) + 1 == batch->count) {
+      std::lock_guard lock(mutex);
+      batchFinished.notify_all();
+    }
+  }
+
+  // All indices are claimed, so nobody else has to pick this batch up anymore
+  std::lock_guard lock(mutex);
+  std::erase(batches, batch);
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::shared_ptr<Batch> batch;
+    {
+      std::unique_lock lock(mutex);
+      workAvailable.wait(lock, [this]() { return stopping || !batches.empty(); });
+      if (batches.empty()) {
+        return;
+      }
+      batch = batches.front();
+    }
+    WorkOn(batch);
+  }
+}
+
+void ThreadPool::Dispatch(JobInvoker invoke, void const *job, size_t count) {
+  if (count == 0) {
+    return;
+  }
+  auto batch = std::make_shared<Batch>(invoke, job, count);
+  if (count > 1 && !workers.empty()) {
+    {
+      std::lock_guard lock(mutex);
+      batches.push_back(batch);
+    }
+    workAvailable.notify_all();
+  }
+
+  WorkOn(batch);
+
+  std::unique_lock lock(mutex);
+  batchFinished.wait(lock, [&batch]() { return batch->finished.load() == batch->count; });
+}
+
+} // namespace Engine::Util
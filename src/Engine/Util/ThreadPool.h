@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Engine::Util {
+
+// Fixed set of worker threads that split index ranges between them. The thread calling ParallelFor works on its own
+// batch as well, so batches can be nested (e.g. a job that itself calls ParallelFor) without deadlocking the pool.
+class ThreadPool {
+  using JobInvoker = void (*)(void const *job, size_t index);
+
+  struct Batch {
+    JobInvoker invoke;
+    void const *job;
+    size_t count;
+    std::atomic<size_t> next;
+    std::atomic<size_t> finished;
+
+    Batch(JobInvoker invoke, void const *job, size_t count)
+        : invoke(invoke), job(job), count(count), next(0), finished(0) {}
+  };
+
+  std::vector<std::thread> workers;
+  std::deque<std::shared_ptr<Batch>> batches;
+  std::mutex mutex;
+  std::condition_variable workAvailable;
+  std::condition_variable batchFinished;
+  bool stopping;
+
+  void WorkerLoop();
+  void WorkOn(std::shared_ptr<Batch> const &batch);
+  void Dispatch(JobInvoker invoke, void const *job, size_t count);
+
+public:
+  ThreadPool(size_t workerCount = DefaultWorkerCount());
+  ~ThreadPool();
+  ThreadPool(ThreadPool const &) = delete;
+  void operator=(ThreadPool const &) = delete;
+
+  inline size_t WorkerCount() const { return workers.size(); }
+
+  // Calls job(i) for every i in [0, count) and returns once all calls are done. Indices are claimed in increasing
+  // order, but may run concurrently on any thread.
+  template <typename Job> inline void ParallelFor(size_t count, Job const &job) {
+    Dispatch([](void const *context, size_t index) { (*static_cast<Job const *>(context))(index); }, &job, count);
+  }
+
+  static size_t DefaultWorkerCount();
+  static ThreadPool &Shared();
+};
+
+} // namespace Engine::Util
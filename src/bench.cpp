@@ -0,0 +1,41 @@
+#include "Tests/ECSBenchmarks.h"
+#include "Tests/MathsBenchmarks.h"
+#include "Tests/TransformBenchmarks.h"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace Engine::Test;
+
+// Usage: BenchApp [--filter <suite/name part>] [--warmup <runs>] [--runs <runs>] [--json <file>]
+int main(int argc, char **argv) {
+  size_t warmupRuns = 3;
+  size_t runs = 30;
+  std::string filter = "";
+  std::string jsonPath = "";
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--filter")) {
+      filter = argv[i + 1];
+    } else if (!strcmp(argv[i], "--warmup")) {
+      warmupRuns = std::strtoull(argv[i + 1], nullptr, 10);
+    } else if (!strcmp(argv[i], "--runs")) {
+      runs = std::strtoull(argv[i + 1], nullptr, 10);
+    } else if (!strcmp(argv[i], "--json")) {
+      jsonPath = argv[i + 1];
+    } else {
+      Engine::Debug::Logging::PrintError("Benchmark", "Unknown option {}!", argv[i]);
+      return 1;
+    }
+  }
+
+  BenchmarkEnv env(warmupRuns, runs, filter);
+
+  RUN_BENCHMARK(maths)
+  RUN_BENCHMARK(ecs)
+  RUN_BENCHMARK(transforms)
+
+  if (!jsonPath.empty() && !env.WriteJson(jsonPath)) {
+    return 1;
+  }
+  return 0;
+}
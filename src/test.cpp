@@ -1,5 +1,7 @@
 #include "Tests/AlignmentTests.h"
+#include "Tests/ECSTests.h"
 #include "Tests/MathsTests.h"
+#include "Tests/TransformTests.h"
 
 using namespace Engine::Test;
 
@@ -7,6 +9,8 @@ BEGIN_TEST_CASE(all)
 
 RUN_SUB_CASE(maths)
 RUN_SUB_CASE(alignment)
+RUN_SUB_CASE(ecs)
+RUN_SUB_CASE(transforms)
 
 END_TEST_CASE() // all
 